@@ -0,0 +1,103 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+
+/*
+ * LoRa time-on-air according to Semtech AN1200.13 ("LoRa Modem Designer's
+ * Guide") and the SX1276 datasheet, section 4.1.1.7.
+ *
+ * All functions are constexpr, so the firmware can derive its transmission
+ * scheme at compile time, and host tools use the very same numbers.
+ * Times are exact integers in microseconds for all LoRaWAN modulations.
+ */
+
+/* MHDR (1) + DevAddr (4) + FCtrl (1) + FCnt (2) + FPort (1) + MIC (4) */
+#define AIRTIME_LORAWAN_OVERHEAD_SIZE 13
+#define AIRTIME_LORAWAN_PREAMBLE_SYMBOLS 8
+
+/* TTN fair use policy: 30 s of uplink airtime per node and 24 h */
+#define AIRTIME_TTN_BUDGET_US_PER_DAY (30UL * 1000 * 1000)
+#define AIRTIME_SECONDS_PER_DAY (24UL * 60 * 60)
+
+typedef struct {
+  uint8_t spreadingFactor;    // 7 .. 12
+  uint16_t bandwidthKHz;      // 125, 250, or 500
+  uint8_t codingRate;         // 1 .. 4 for 4/5 .. 4/8
+  bool explicitHeader;
+  bool crc;
+  bool lowDataRateOptimize;
+  uint8_t preambleSymbols;
+} lora_parameters_t;
+
+/**
+ * Modulation parameters of the EU868 uplink datarates.
+ *
+ * The datarate follows the LMIC DR_XX enums: DR_SF12 is 0, DR_SF7B is 6.
+ * LoRaWAN mandates low datarate optimization for SF11 and SF12 at 125 kHz.
+ */
+constexpr lora_parameters_t airtimeParametersOfDatarate(uint8_t datarate) {
+  return {
+    static_cast<uint8_t>(datarate >= 5 ? 7 : 12 - datarate),
+    static_cast<uint16_t>(datarate == 6 ? 250 : 125),
+    1,
+    true,
+    true,
+    datarate <= 1,
+    AIRTIME_LORAWAN_PREAMBLE_SYMBOLS
+  };
+}
+
+/**
+ * Symbol duration in microseconds
+ */
+constexpr uint32_t airtimeSymbolUs(const lora_parameters_t &parameters) {
+  return (1000UL << parameters.spreadingFactor) / parameters.bandwidthKHz;
+}
+
+/* ceil(numerator / denominator) for the payload symbol formula, never negative */
+constexpr int32_t airtimeCeilBlocks(int32_t numerator, int32_t denominator) {
+  return numerator <= 0 ? 0 : (numerator + denominator - 1) / denominator;
+}
+
+/**
+ * Number of payload symbols, including the 8 symbols of the PHY header block
+ */
+constexpr uint32_t airtimePayloadSymbols(const lora_parameters_t &parameters, uint8_t phyPayloadSize) {
+  return 8 + airtimeCeilBlocks(
+      8 * phyPayloadSize - 4 * parameters.spreadingFactor + 28
+        + (parameters.crc ? 16 : 0) - (parameters.explicitHeader ? 0 : 20),
+      4 * (parameters.spreadingFactor - (parameters.lowDataRateOptimize ? 2 : 0)))
+    * (parameters.codingRate + 4);
+}
+
+/**
+ * Time-on-air of a LoRa frame with the given PHY payload size in microseconds.
+ *
+ * The preamble lasts preambleSymbols + 4.25 symbols; we count in quarter
+ * symbols so that the result stays exact.
+ */
+constexpr uint32_t airtimeUs(const lora_parameters_t &parameters, uint8_t phyPayloadSize) {
+  return (4 * (parameters.preambleSymbols + airtimePayloadSymbols(parameters, phyPayloadSize)) + 17)
+    * airtimeSymbolUs(parameters) / 4;
+}
+
+/**
+ * Time-on-air of a LoRaWAN uplink with the given application payload size
+ * in microseconds.
+ */
+constexpr uint32_t airtimeOfUplinkUs(uint8_t datarate, uint8_t applicationPayloadSize) {
+  return airtimeUs(airtimeParametersOfDatarate(datarate), applicationPayloadSize + AIRTIME_LORAWAN_OVERHEAD_SIZE);
+}
+
+/**
+ * Shortest interval between uplinks of the given airtime that stays within
+ * the TTN fair use budget, in seconds (rounded up).
+ */
+constexpr uint32_t airtimeMinTransmissionIntervalSecs(uint32_t uplinkAirtimeUs) {
+  return static_cast<uint32_t>(
+      (static_cast<uint64_t>(uplinkAirtimeUs) * AIRTIME_SECONDS_PER_DAY + AIRTIME_TTN_BUDGET_US_PER_DAY - 1)
+      / AIRTIME_TTN_BUDGET_US_PER_DAY);
+}
+
+#endif /* AIRTIME_H */
@@ -0,0 +1,58 @@
+#include "airtime_budget.h"
+
+AirtimeBudget::AirtimeBudget(uint32_t budgetUsPerDayArg) {
+  budgetUsPerDay = budgetUsPerDayArg;
+
+  for (uint8_t i = 0; i < AIRTIME_BUDGET_NROF_SLOTS; i++) {
+    slotsUs[i] = 0;
+  }
+  currentSlot = 0;
+  secondsInCurrentSlot = 0;
+  completedSlots = 0;
+}
+
+void AirtimeBudget::advance(uint16_t seconds) {
+  uint32_t secondsInSlot = secondsInCurrentSlot + static_cast<uint32_t>(seconds);
+
+  while (secondsInSlot >= AIRTIME_BUDGET_SLOT_SECS) {
+    secondsInSlot -= AIRTIME_BUDGET_SLOT_SECS;
+    currentSlot = (currentSlot + 1) % AIRTIME_BUDGET_NROF_SLOTS;
+    slotsUs[currentSlot] = 0;
+    if (completedSlots < AIRTIME_BUDGET_NROF_SLOTS_PER_DAY) completedSlots += 1;
+  }
+
+  secondsInCurrentSlot = secondsInSlot;
+}
+
+void AirtimeBudget::charge(uint32_t airtimeUs) {
+  slotsUs[currentSlot] += airtimeUs;
+}
+
+uint32_t AirtimeBudget::usedUs() {
+  uint32_t used = 0;
+  for (uint8_t i = 0; i < AIRTIME_BUDGET_NROF_SLOTS; i++) {
+    used += slotsUs[i];
+  }
+  return used;
+}
+
+bool AirtimeBudget::allows(uint32_t airtimeUs) {
+  return usedUs() + airtimeUs <= budgetUsPerDay;
+}
+
+uint32_t AirtimeBudget::allowanceUsPerHour() {
+  int32_t used = usedUs();
+  int32_t nominal = budgetUsPerDay / AIRTIME_BUDGET_NROF_SLOTS_PER_DAY;
+  // what the window would hold had we spent the nominal share since we started
+  int32_t expected = nominal * completedSlots;
+
+  int32_t allowance = nominal + (expected - used) / AIRTIME_BUDGET_NROF_SLOTS_PER_DAY;
+
+  // the oldest slot drops out of the window at the next slot boundary
+  uint8_t oldestSlot = (currentSlot + 1) % AIRTIME_BUDGET_NROF_SLOTS;
+  int32_t spendable = static_cast<int32_t>(budgetUsPerDay) - used + static_cast<int32_t>(slotsUs[oldestSlot]);
+
+  if (allowance > spendable) allowance = spendable;
+  if (allowance < 0) allowance = 0;
+  return allowance;
+}
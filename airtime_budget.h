@@ -0,0 +1,64 @@
+#ifndef AIRTIME_BUDGET_H
+#define AIRTIME_BUDGET_H
+
+#include <stdint.h>
+#include "airtime.h"
+
+#define AIRTIME_BUDGET_SLOT_SECS 3600
+#define AIRTIME_BUDGET_NROF_SLOTS_PER_DAY 24
+/* one more slot than a day, so that airtime is accounted for at least 24 h */
+#define AIRTIME_BUDGET_NROF_SLOTS (AIRTIME_BUDGET_NROF_SLOTS_PER_DAY + 1)
+
+/**
+ * Tracks the uplink airtime spent within a rolling 24 h window.
+ *
+ * The window consists of one-hour slots. Time is advanced explicitly by the
+ * caller, so the budget does not depend on any clock.
+ */
+class AirtimeBudget {
+  public:
+    /**
+     * Constructor
+     */
+    AirtimeBudget(uint32_t budgetUsPerDay = AIRTIME_TTN_BUDGET_US_PER_DAY);
+
+    /**
+     * Let the given number of seconds pass.
+     */
+    void advance(uint16_t seconds);
+
+    /**
+     * Account for an uplink of the given airtime.
+     */
+    void charge(uint32_t airtimeUs);
+
+    /**
+     * Airtime spent within the last 24 h
+     */
+    uint32_t usedUs();
+
+    /**
+     * Returns whether an uplink of the given airtime stays within the budget.
+     */
+    bool allows(uint32_t airtimeUs);
+
+    /**
+     * Airtime to spend per hour from now on
+     *
+     * In steady state, this is an even share of the daily budget. Airtime left
+     * unused in the window, e.g., after a period of cheap uplinks, is spread
+     * over the next 24 h; overspending is paid back the same way. The result
+     * never exceeds what may be spent until the oldest slot expires.
+     */
+    uint32_t allowanceUsPerHour();
+
+  private:
+    uint32_t budgetUsPerDay;
+
+    uint32_t slotsUs[AIRTIME_BUDGET_NROF_SLOTS];
+    uint8_t currentSlot;
+    uint16_t secondsInCurrentSlot;
+    uint8_t completedSlots;
+};
+
+#endif /* AIRTIME_BUDGET_H */
@@ -1,6 +1,5 @@
 #include "blinking_display.h"
 #include <Arduino.h>
-#include <arduino_lmic.h>
 
 #define PERIOD_GOOD 1000
 #define PERIOD_FAIR 500
@@ -8,22 +7,27 @@
 #define PERIOD_ERROR 125
 #define PERIOD_ERROR_SILENCE 1000
 
-// unfortunately, LMIC's osjob_t does not support job-specific data
-// so we have to keep this in static memory
-static osjob_t blinkJob;
-static uint16_t currentPeriod;
-static int currentValue;
-static int errorCodeNumber;
-static int errorBlinkCounter;
+// an LED blinking a little unevenly is fine, if it lets the CPU sleep longer
+#define BLINK_TOLERANCE (PERIOD_ERROR / 2)
 
+BlinkingDisplay::BlinkingDisplay(TimerService *timersArg) : blinkTimer(onBlinkTimer, this) {
+  timers = timersArg;
+  currentPeriod = PERIOD_GOOD;
+  currentValue = LOW;
+  errorCodeNumber = static_cast<int>(ErrorCode::NO_ERROR);
+  errorBlinkCounter = 0;
+  nextBlinkTime = 0;
+}
 
-static bool errorHasOccurred() {
+bool BlinkingDisplay::errorHasOccurred() {
   return errorCodeNumber != static_cast<int>(ErrorCode::NO_ERROR);
 }
 
-static void blink(osjob_t *job) {
-  (void) (job); // unused
+void BlinkingDisplay::onBlinkTimer(void *context) {
+  static_cast<BlinkingDisplay *>(context)->blink();
+}
 
+void BlinkingDisplay::blink() {
   currentValue = currentValue == HIGH ? LOW : HIGH;
   digitalWrite(LED_BUILTIN, currentValue);
 
@@ -39,18 +43,20 @@ static void blink(osjob_t *job) {
     }
   }
 
-  ostime_t nextBlinkTick = os_getTime() + ms2osticks(currentPeriod);
-  os_setTimedCallback(&blinkJob, nextBlinkTick, blink);
+  // relative to the previous deadline, so that blinks that run late do not slow the LED down
+  nextBlinkTime += ms2osticks(currentPeriod);
+  if (nextBlinkTime - os_getTime() < 0) nextBlinkTime = os_getTime();
+  timers->schedule(&blinkTimer, nextBlinkTime, ms2osticks(BLINK_TOLERANCE));
 }
 
-
 void BlinkingDisplay::setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   currentPeriod = PERIOD_GOOD;
   currentValue = HIGH;
   errorCodeNumber = static_cast<int>(ErrorCode::NO_ERROR);
   errorBlinkCounter = 0;
-  os_setCallback(&blinkJob, blink);
+  nextBlinkTime = os_getTime();
+  timers->schedule(&blinkTimer, nextBlinkTime);
 }
 
 void BlinkingDisplay::displayCurrentCO2Concentration(uint16_t co2Concentration) {
@@ -69,6 +75,19 @@ void BlinkingDisplay::displayCurrentCO2Concentration(uint16_t co2Concentration)
     default:
       currentPeriod = PERIOD_BAD;
   }
+
+  /*
+   * The periods divide the measuring period. Unless blinks already fall on
+   * measurements, they start over from this one, so that they share the
+   * wakeups of the next ones.
+   */
+  ostime_t period = ms2osticks(currentPeriod);
+  ostime_t offset = (nextBlinkTime - os_getTime()) % period;
+  if (offset < 0) offset += period;
+  if (offset > ms2osticks(BLINK_TOLERANCE) && period - offset > ms2osticks(BLINK_TOLERANCE)) {
+    nextBlinkTime = os_getTime() + period;
+    timers->schedule(&blinkTimer, nextBlinkTime, ms2osticks(BLINK_TOLERANCE));
+  }
 }
 
 void BlinkingDisplay::displayError(ErrorCode errorCode) {
@@ -2,18 +2,36 @@
 #define BLINKING_DISPLAY_H
 
 #include "debug_display.h"
+#include "timer_service.h"
 #include <stdint.h>
 
 /**
- * WARNING: The state of the BlinkingDisplay is kept in static memory, since
- * LMIC's osjob_t does not support job-specific data.
- * Make sure that only one BlinkingDisplay is instantiated.
+ * Blinks LED_BUILTIN the faster the worse the air quality, and the error
+ * code in bursts.
  */
 class BlinkingDisplay: public DebugDisplay {
   public:
+    /**
+     * Constructor
+     */
+    BlinkingDisplay(TimerService *timers);
+
     void setup() override;
     void displayCurrentCO2Concentration(uint16_t co2Concentration) override;
     void displayError(ErrorCode errorCode) override;
+
+  private:
+    TimerService *timers;
+    Timer blinkTimer;
+    uint16_t currentPeriod;
+    int currentValue;
+    int errorCodeNumber;
+    int errorBlinkCounter;
+    ostime_t nextBlinkTime;
+
+    bool errorHasOccurred();
+    void blink();
+    static void onBlinkTimer(void *context);
 };
 
 #endif /* BLINKING_DISPLAY_H */
@@ -0,0 +1,24 @@
+#include "checksum.h"
+
+/*
+ * The sums are only reduced modulo 255 after this many bytes, the most for
+ * which the second sum cannot overflow 32 bits. The Cortex-M0 has no divider.
+ */
+#define FLETCHER16_BLOCK_SIZE 5802
+
+uint16_t fletcher16(const uint8_t *data, size_t size, uint16_t initial) {
+  uint32_t sum1 = initial & 0xFF;
+  uint32_t sum2 = initial >> 8;
+  while (size > 0) {
+    size_t blockSize = size < FLETCHER16_BLOCK_SIZE ? size : FLETCHER16_BLOCK_SIZE;
+    size -= blockSize;
+    for (size_t i = 0; i < blockSize; i++) {
+      sum1 += data[i];
+      sum2 += sum1;
+    }
+    data += blockSize;
+    sum1 %= 255;
+    sum2 %= 255;
+  }
+  return sum2 << 8 | sum1;
+}
@@ -0,0 +1,14 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Fletcher-16 checksum, which, unlike a plain sum, detects swapped bytes
+ *
+ * To checksum several ranges, pass the result of the previous range as initial value.
+ */
+uint16_t fletcher16(const uint8_t *data, size_t size, uint16_t initial = 0);
+
+#endif /* CHECKSUM_H */
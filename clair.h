@@ -2,26 +2,159 @@
 #define CLAIR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "sensor.h"
+#include "airtime_budget.h"
+#include "decimation_filter.h"
+#include "sample_queue.h"
+#include "sample_log.h"
+#include "swinging_door.h"
+#include "clair_protocol.h"
+#include "display.h"
 
-/* sizes in bytes */
-#define CLAIR_HEADER_SIZE 1
-#define CLAIR_SAMPLE_SIZE 2
-#define CLAIR_MAX_NROF_SAMPLES_PER_MESSAGE 5
-#define CLAIR_MAX_MESSAGE_SIZE (CLAIR_MAX_NROF_SAMPLES_PER_MESSAGE * CLAIR_SAMPLE_SIZE + CLAIR_HEADER_SIZE)
 
-#define CLAIR_MEASURING_PERIOD_SECS 5
-#define CLAIR_MAX_SAMPLINE_PERIOD_MINS 14
+/*
+ * Each sample averages all measurements taken within its sampling period.
+ * In windowed sampling mode, the sensor takes Config::MEASUREMENTS_PER_SAMPLE
+ * measurements spread evenly over the period, and sleeps in between.
+ * Otherwise, it measures every Config::MEASURING_PERIOD_SECS.
+ */
+#ifndef CLAIR_WINDOWED_SAMPLING
+#define CLAIR_WINDOWED_SAMPLING 1
+#endif
+
+/*
+ * If non-zero, the node does not send equispaced samples but the breakpoints
+ * of a piecewise-linear approximation of its readings, which deviates from
+ * the CO2 readings by at most this number of ppm. The sensor then measures
+ * every Config::MEASURING_PERIOD_SECS.
+ */
+#ifndef CLAIR_SWINGING_DOOR_DEVIATION_PPM
+#define CLAIR_SWINGING_DOOR_DEVIATION_PPM 0
+#endif
+
+typedef struct {
+  uint16_t samplingPeriodSeconds;
+  uint8_t samplesPerMessage;
+} transmission_config_t;
+
+typedef struct {
+  uint8_t messageId;
+  uint8_t messageHeader; // 3 bits
+  uint8_t numberOfSamples;
+  uint8_t length; // of the encoded samples in bytes
+} clair_encoding_t;
 
 /**
  * A Clair object keeps the state of the transmission adaptation algorithm.
+ *
+ * SensorT provides the Sensor methods; declare it final so that the compiler
+ * can call them directly. Config describes the node model at compile time:
+ *
+ * - Codec: encodeSample(), decodeSample(), encodesLike(), encodeDeltaSamples(),
+ *   encodeRiceSamples(), compressedSamplesSize(), and SAMPLE_SIZE in bytes,
+ *   see clairchen_codec.h
+ * - MEASURING_PERIOD_SECS, SENSOR_WARMUP_SECS, MEASUREMENTS_PER_SAMPLE
+ * - MAX_NROF_SAMPLES_PER_MESSAGE, SAMPLE_QUEUE_CAPACITY
+ * - SAMPLING_PERIOD_UNIT_SECS, MIN_SAMPLING_PERIOD_SECS, MAX_SAMPLING_PERIOD_SECS
+ * - WINDOWED_SAMPLING
+ * - SWINGING_DOOR_DEVIATION_PPM, 0 to send equispaced samples
+ * - HEARTBEAT_INTERVAL_SECS, 0 to send unchanged samples
+ * - ALERT_TREND_PPM_PER_MINUTE (0 for no trend alerts), ALERT_TREND_WINDOW_SECS,
+ *   AIR_QUALITY_HYSTERESIS_PPM, MIN_ALERT_INTERVAL_SECS
+ *
+ * See clairchen_config.h for the Clairchen node.
+ *
+ * Optionally, samples that drop out of the full sample queue are stored in a
+ * SampleLog, and sent as backfill lists once there is airtime to spare.
  */
+template <typename SensorT, typename Config>
 class Clair {
   public:
+    typedef typename Config::Codec Codec;
+
+    static constexpr uint8_t MAX_MESSAGE_SIZE =
+      CLAIR_HEADER_SIZE + Config::MAX_NROF_SAMPLES_PER_MESSAGE * Codec::SAMPLE_SIZE + CLAIR_SAMPLE_AGE_MAX_SIZE;
+
+    static constexpr uint8_t ALERT_MESSAGE_SIZE = CLAIR_HEADER_SIZE + Codec::SAMPLE_SIZE;
+    static constexpr uint8_t HEARTBEAT_MESSAGE_SIZE = CLAIR_HEADER_SIZE;
+
+    /* whether breakpoints are sent instead of equispaced samples */
+    static constexpr bool SENDS_BREAKPOINTS = Config::SWINGING_DOOR_DEVIATION_PPM > 0;
+
     /**
      * Constructor
+     *
+     * sampleLog may be NULL; otherwise, its begin() must have been called.
+     */
+    Clair(SensorT *sensor, SampleLog *sampleLog = NULL);
+
+    /**
+     * The state of sampling and transmission, to keep across a warm reset
+     */
+    struct State {
+      State() : swingingDoor(Config::SWINGING_DOOR_DEVIATION_PPM, UINT8_MAX * CLAIR_BREAKPOINT_OFFSET_UNIT_SECS) {}
+
+      DecimationFilter decimationFilter;
+      SampleQueue<Config::SAMPLE_QUEUE_CAPACITY> sampleQueue;
+      uint16_t secondsSinceLastSample;
+
+      /* the sampling period in effect, which lags behind the planned one until a message is complete */
+      uint16_t samplingPeriodSeconds;
+      uint16_t samplesAtSamplingPeriod;
+
+      uint32_t uptimeSeconds;
+      /* UTC = uptimeSeconds + wallClockOffsetSeconds, once known */
+      bool wallClockKnown;
+      uint32_t wallClockOffsetSeconds;
+      uint32_t wallClockSetSeconds;
+
+      int currentDatarate;
+      /* observed bits per delta-encoded sample in the last message, for planning */
+      uint8_t expectedBitsPerDelta;
+      AirtimeBudget airtimeBudget;
+
+      /* breakpoint mode */
+      SwingingDoor swingingDoor;
+      clair_sample_t breakpoints[CLAIR_MAX_NROF_SAMPLES_IN_HEADER];
+      uint32_t breakpointTimes[CLAIR_MAX_NROF_SAMPLES_IN_HEADER];
+      uint8_t numberOfBreakpoints;
+      uint32_t lastMessageSeconds;
+      uint32_t lastTransmittedBreakpointTime;
+
+      /* send-on-delta: the encoding of the last transmitted sample or breakpoint */
+      uint8_t lastTransmittedSample[Codec::SAMPLE_SIZE];
+      bool sampleTransmitted;
+
+      /* alerts */
+      clair_sample_t latestSample;
+      CO2AirQuality reportedAirQuality;
+      uint16_t trendReferenceCO2ppm;
+      uint32_t trendReferenceSeconds;
+      int16_t co2TrendPpmPerMinute;
+      bool steepTrend;
+      bool trendAlertPending;
+      bool alertSent;
+      uint32_t lastAlertSeconds;
+
+      /* the samples in the sample log that have not been sent, only filled in by saveState() */
+      uint16_t numberOfLoggedSamples;
+    };
+
+    /**
+     * Save the state, e.g., to retained RAM after each measurement and transmission.
      */
-    Clair(Sensor *sensor);
+    void saveState(State *savedState);
+
+    /**
+     * Continue with a saved state, in the middle of its sampling period.
+     *
+     * To be called after setup(). The time spent in the reset is not
+     * accounted for, so the wall-clock time is due to be set again. Logged
+     * samples that had not been sent yet are taken over from the sample log,
+     * as they are stamped with the same clock.
+     */
+    void restoreState(const State &savedState);
 
     /**
      * To be called in the Arduino setup hook
@@ -35,12 +168,37 @@ class Clair {
     /**
      * Get CO2 concentration in ppm
      *
-     * Must be called once per CLAIR_MEASURING_PERIOD_SECS.
+     * Must be called getSecondsUntilNextMeasurement() after the previous call.
+     * While the sensor warms up, the last measured concentration is returned.
      *
      * Returns a negative value if the measurement failed.
      */
     int16_t getCO2Concentration();
 
+    /**
+     * Returns when getCO2Concentration() is to be called next.
+     */
+    uint16_t getSecondsUntilNextMeasurement();
+
+    /**
+     * Set the wall-clock time of the last measurement in seconds, i.e., the
+     * GPS time from the network. Clair subtracts
+     * Config::GPS_UTC_OFFSET_SECS, so that the grid is aligned to UTC.
+     *
+     * From then on, measurements are taken on multiples of the measuring
+     * period in UTC. From the next message on, samples end on
+     * multiples of the sampling period, so that all nodes sample at the same
+     * instants. The next measurement may move by up to a measuring period;
+     * call getSecondsUntilNextMeasurement() again.
+     */
+    void setWallClockSeconds(uint32_t wallClockSeconds);
+
+    /**
+     * Returns whether the wall-clock time should be set, because it is not
+     * known or has not been set for Config::WALL_CLOCK_SYNC_INTERVAL_SECS.
+     */
+    bool isWallClockSyncDue();
+
     /**
      * Set the current datarate which determines the transmission rate.
      *
@@ -48,35 +206,153 @@ class Clair {
      */
     void setCurrentDatarate(int datarate);
 
+    /**
+     * Returns the sampling period and the number of samples per message
+     * planned for the current datarate and airtime budget.
+     *
+     * A new sampling period takes effect with the next message, so that the
+     * samples of each message are equispaced.
+     */
+    transmission_config_t getTransmissionConfig();
+
     /**
      * Returns whether a message is due
      *
      * Should be called after calling getCO2Concentration().
+     * When sending breakpoints, a message is due once the airtime allowance
+     * covers it or once it is full.
      * If a message is due, encodeMessage() should be called and the message be sent.
-     * If encodeMessage() is not called even though a message is due the oldest 
-     * sample is discarded once a new sample is added to the message buffer.
+     * Samples that are not sent, e.g., because the radio is busy or a message
+     * would exceed the airtime budget, queue up. Once the queue holds more than
+     * a message, messages are due until it has been drained. If the queue is
+     * full, the oldest sample is moved to the sample log, or discarded.
+     *
+     * Logged samples are sent in backfill lists while the queue holds less
+     * than a message, if the airtime budget keeps an hour of the planned
+     * messages in reserve.
+     *
+     * Samples that encode like the last transmitted one, or that only differ
+     * because they dither across a rounding boundary, are not added to an
+     * empty message buffer. Instead, a heartbeat is due once no message has
+     * been sent for Config::HEARTBEAT_INTERVAL_SECS.
      */
     bool isMessageDue();
 
     /**
      * Returns the length of the encoded message
+     *
+     * Messages hold the oldest queued samples. Call commitMessage() once the
+     * message has been handed over for transmission; otherwise, its samples
+     * remain queued.
+     *
+     * Sample lists tell the age of their last sample at transmission, for
+     * which secondsSinceMeasurement gives the time since the last call of
+     * getCO2Concentration(). Encode messages only right before they can go
+     * on air.
      */
-    uint8_t encodeMessage(uint8_t *messageBuffer, uint16_t messageBufferSize);
+    uint8_t encodeMessage(uint8_t *messageBuffer, uint16_t messageBufferSize, uint16_t secondsSinceMeasurement = 0);
+
+    /**
+     * Returns how old the newest sample of the last encoded message or alert
+     * was at the last measurement, in seconds; 0 for heartbeats and alerts,
+     * which carry the latest reading.
+     */
+    uint32_t getEncodedSampleAgeSeconds();
+
+    /**
+     * Removes the samples of the last encoded message from the queue, or
+     * marks the last encoded alert as reported.
+     *
+     * The airtime of the message or alert is charged against the airtime
+     * budget, and the transmission of the samples is replanned to make up
+     * for it.
+     */
+    void commitMessage();
+
+    /**
+     * Returns whether an alert is due
+     *
+     * An alert is due if the air quality category has changed since the last
+     * alert, or if the CO2 concentration has started to change faster than
+     * Config::ALERT_TREND_PPM_PER_MINUTE, at most every
+     * Config::MIN_ALERT_INTERVAL_SECS and within the airtime budget.
+     * Should be called after calling getCO2Concentration().
+     */
+    bool isAlertDue();
+
+    /**
+     * Returns the length of the encoded alert
+     *
+     * Call commitMessage() once the alert has been handed over for
+     * transmission; otherwise, it remains due.
+     */
+    uint8_t encodeAlert(uint8_t *messageBuffer, uint16_t messageBufferSize);
 
   private:
-    Sensor *sensor;
+    SensorT *sensor;
+    SampleLog *sampleLog;
+
+    /* everything that saveState() keeps across a warm reset */
+    State state;
+
+    void adoptSamplingPeriod();
+
+    /* the oldest samples of the queue, contiguous for encoding */
+    clair_sample_t sampleBuffer[Config::MAX_NROF_SAMPLES_PER_MESSAGE];
+
+    /* the message encoded last, until it is committed */
+    uint8_t encodedMessageId;
+    uint8_t encodedNumberOfSamples;
+    uint8_t encodedLength;
+    uint32_t encodedSampleAgeSeconds;
 
-    clair_sample_t minuteBuffer[60 / CLAIR_MEASURING_PERIOD_SECS];
-    uint8_t indexOfNextSampleInMinuteBuffer;
+    uint8_t plannedMessageSize(uint8_t numberOfSamples);
+    clair_encoding_t encodeSamples(uint8_t *messageBuffer, uint16_t messageBufferSize);
 
-    void addSampleToMinuteBuffer(clair_sample_t sample);
-    clair_sample_t getAverageSampleOfLastMinute();
+    /* the samples of the next sample list, without header and age, encoded until the queue changes */
+    uint8_t samplesMessage[MAX_MESSAGE_SIZE - CLAIR_HEADER_SIZE - CLAIR_SAMPLE_AGE_MAX_SIZE];
+    clair_encoding_t samplesEncoding;
+    bool samplesEncoded;
 
-    clair_sample_t sampleBuffer[CLAIR_MAX_NROF_SAMPLES_PER_MESSAGE];
-    uint16_t secondsSinceLastSample;
-    uint8_t numberOfSamplesInBuffer;
+    const clair_encoding_t &pendingSamples();
+    /* returns the size of the age field, 0 for an age of 0; encodes it if messageBuffer is not null */
+    static uint8_t encodeSampleAge(uint32_t ageSeconds, uint8_t *messageBuffer);
 
-    int currentDatarate;
+    uint16_t secondsUntilNextMeasurement;
+    bool sensorSleeping;
+    int16_t lastCO2ppm;
+
+    void planNextMeasurement();
+    void alignSamplingPeriod();
+
+    transmission_config_t transmissionConfig;
+
+    void planTransmission();
+
+    bool isUnchanged(clair_sample_t sample);
+    bool isHeartbeatDue();
+    bool hasSamplingPeriodChanged();
+    uint8_t encodeHeartbeat(uint8_t *messageBuffer, uint16_t messageBufferSize);
+
+    /* the backfill list of the oldest logged samples, without its age, encoded until the log changes */
+    uint8_t backfillMessage[MAX_MESSAGE_SIZE];
+    clair_encoding_t backfillEncoding;
+    uint32_t backfillLastTime;
+    bool backfillEncoded;
+
+    clair_encoding_t encodeBackfill(uint8_t *messageBuffer, uint16_t messageBufferSize);
+    const clair_encoding_t &pendingBackfill();
+    bool isBackfillDue();
+
+    void addBreakpoint(clair_sample_t breakpoint, uint32_t time);
+    uint8_t breakpointMessageSize(uint8_t numberOfBreakpoints);
+    bool isBreakpointMessageDue();
+    uint8_t encodeBreakpointMessage(uint8_t *messageBuffer, uint16_t messageBufferSize);
+
+    void updateAlertState(clair_sample_t sample);
+    bool hasAirQualityChanged();
 };
 
+#include "clair_impl.h"
+
 #endif /* CLAIR_H */
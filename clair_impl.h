@@ -0,0 +1,898 @@
+#ifndef CLAIR_IMPL_H
+#define CLAIR_IMPL_H
+
+/*
+ * Member definitions of the Clair template; include clair.h instead.
+ */
+
+#include "clair.h"
+#include "sensor.h"
+#include "debug.h"
+#include "airtime.h"
+#include <algorithm>
+#include <string.h>
+
+// the uplink datarates DR_SF12 to DR_SF7B of the LMIC DR_XX enums
+#define CLAIR_NROF_DATARATES 7
+
+template <typename SensorT, typename Config>
+constexpr uint8_t Clair<SensorT, Config>::MAX_MESSAGE_SIZE;
+
+template <typename SensorT, typename Config>
+constexpr uint8_t Clair<SensorT, Config>::ALERT_MESSAGE_SIZE;
+
+template <typename SensorT, typename Config>
+constexpr uint8_t Clair<SensorT, Config>::HEARTBEAT_MESSAGE_SIZE;
+
+template <typename SensorT, typename Config>
+constexpr bool Clair<SensorT, Config>::SENDS_BREAKPOINTS;
+
+template <typename SensorT, typename Config>
+Clair<SensorT, Config>::Clair(SensorT *sensorArg, SampleLog *sampleLogArg) {
+  static_assert(Config::SAMPLING_PERIOD_UNIT_SECS == CLAIR_SAMPLING_PERIOD_UNIT_SECS,
+      "the sampling period must be sent in the unit of the message format");
+  static_assert(Config::MAX_SAMPLING_PERIOD_SECS / Config::SAMPLING_PERIOD_UNIT_SECS <= UINT8_MAX,
+      "the maximum sampling period must fit into the message");
+  static_assert(Config::SAMPLING_PERIOD_UNIT_SECS % Config::MEASURING_PERIOD_SECS == 0,
+      "sampling periods must be multiples of the measuring period");
+  static_assert(Config::MIN_SAMPLING_PERIOD_SECS >= Config::MEASUREMENTS_PER_SAMPLE * Config::MEASURING_PERIOD_SECS,
+      "the measurements of a sample must fit into the sampling period");
+  static_assert(Config::MAX_NROF_SAMPLES_PER_MESSAGE <= Codec::MAX_NROF_RICE_SAMPLES,
+      "the number of samples must fit into the message");
+  static_assert(!SENDS_BREAKPOINTS || Config::MEASURING_PERIOD_SECS % CLAIR_BREAKPOINT_OFFSET_UNIT_SECS == 0,
+      "breakpoint times must be multiples of the offset unit");
+  static_assert(Config::SAMPLE_QUEUE_CAPACITY >= Config::MAX_NROF_SAMPLES_PER_MESSAGE,
+      "the sample queue must hold a full message");
+  static_assert(static_cast<uint32_t>(Config::SAMPLE_QUEUE_CAPACITY) * Config::MAX_SAMPLING_PERIOD_SECS <= CLAIR_SAMPLE_AGE_MAX_SECS,
+      "the age of queued samples must fit into the message");
+
+  static_assert(Codec::SAMPLE_SIZE == SAMPLE_LOG_SAMPLE_SIZE, "the sample log must hold encoded samples");
+
+  sensor = sensorArg;
+  sampleLog = sampleLogArg;
+
+  state.currentDatarate = 0; // SF12
+  state.expectedBitsPerDelta = Codec::SAMPLE_SIZE * 8;
+  state.secondsSinceLastSample = 0;
+  encodedLength = 0;
+  encodedSampleAgeSeconds = 0;
+  samplesEncoded = false;
+  backfillEncoded = false;
+
+  secondsUntilNextMeasurement = Config::MEASURING_PERIOD_SECS;
+  sensorSleeping = false;
+  lastCO2ppm = 0;
+
+  state.uptimeSeconds = 0;
+  state.wallClockKnown = false;
+  state.wallClockOffsetSeconds = 0;
+  state.wallClockSetSeconds = 0;
+  state.lastMessageSeconds = 0;
+  state.numberOfBreakpoints = 0;
+  state.lastTransmittedBreakpointTime = 0;
+  state.sampleTransmitted = false;
+
+  // the first reading sets the reported air quality and the trend reference
+  state.trendReferenceSeconds = 0;
+  state.co2TrendPpmPerMinute = 0;
+  state.steepTrend = false;
+  state.trendAlertPending = false;
+  state.alertSent = false;
+  state.lastAlertSeconds = 0;
+  state.numberOfLoggedSamples = 0;
+
+  planTransmission();
+  state.samplingPeriodSeconds = transmissionConfig.samplingPeriodSeconds;
+  state.samplesAtSamplingPeriod = 0;
+}
+
+// shortest sampling period at which messages of the given airtime and number
+// of samples can be sent with the given airtime allowance
+template <typename Config>
+uint16_t clairSamplingPeriodForAllowance(uint32_t airtimeUs, uint8_t samplesPerMessage, uint32_t allowanceUsPerHour) {
+  if (allowanceUsPerHour == 0) return Config::MAX_SAMPLING_PERIOD_SECS;
+
+  uint64_t transmissionInterval = (static_cast<uint64_t>(airtimeUs) * AIRTIME_BUDGET_SLOT_SECS + allowanceUsPerHour - 1)
+    / allowanceUsPerHour;
+  uint64_t samplingPeriod = (transmissionInterval + samplesPerMessage - 1) / samplesPerMessage;
+  samplingPeriod = (samplingPeriod + Config::SAMPLING_PERIOD_UNIT_SECS - 1)
+    / Config::SAMPLING_PERIOD_UNIT_SECS * Config::SAMPLING_PERIOD_UNIT_SECS;
+
+  if (samplingPeriod < Config::MIN_SAMPLING_PERIOD_SECS) return Config::MIN_SAMPLING_PERIOD_SECS;
+  if (samplingPeriod > Config::MAX_SAMPLING_PERIOD_SECS) return Config::MAX_SAMPLING_PERIOD_SECS;
+  return samplingPeriod;
+}
+
+/*
+ * Delta and Rice encoding only pay off if the samples change little, so we
+ * expect the next message to compress as well as the last one.
+ */
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::plannedMessageSize(uint8_t numberOfSamples) {
+  uint16_t size = Codec::compressedSamplesSize(numberOfSamples, state.expectedBitsPerDelta);
+  if (numberOfSamples <= CLAIR_MAX_NROF_SAMPLES_IN_HEADER) {
+    size = std::min(size, static_cast<uint16_t>(numberOfSamples * Codec::SAMPLE_SIZE));
+  }
+  return CLAIR_HEADER_SIZE + size;
+}
+
+/*
+ * Picks the number of samples per message that yields the shortest sampling
+ * period for the current datarate and airtime allowance. If several numbers
+ * of samples reach the same period, the message is filled up to the end of
+ * the airtime step of the smallest one.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::planTransmission() {
+  uint32_t allowance = state.airtimeBudget.allowanceUsPerHour();
+
+  uint32_t bestAirtime = airtimeOfUplinkUs(state.currentDatarate, plannedMessageSize(1));
+  transmission_config_t best = {
+    .samplingPeriodSeconds = clairSamplingPeriodForAllowance<Config>(bestAirtime, 1, allowance),
+    .samplesPerMessage = 1
+  };
+
+  for (uint8_t samples = 2; samples <= Config::MAX_NROF_SAMPLES_PER_MESSAGE; samples++) {
+    uint32_t airtime = airtimeOfUplinkUs(state.currentDatarate, plannedMessageSize(samples));
+    uint16_t period = clairSamplingPeriodForAllowance<Config>(airtime, samples, allowance);
+
+    if (period < best.samplingPeriodSeconds) {
+      bestAirtime = airtime;
+    } else if (period > best.samplingPeriodSeconds || airtime != bestAirtime) {
+      continue;
+    }
+    best.samplingPeriodSeconds = period;
+    best.samplesPerMessage = samples;
+  }
+
+  transmissionConfig = best;
+}
+
+template <typename SensorT, typename Config>
+transmission_config_t Clair<SensorT, Config>::getTransmissionConfig() {
+  return transmissionConfig;
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::setup() {
+  return sensor->setup();
+}
+
+#define CLAIR_PRINT_SAMPLE(SAMPLE) do { \
+    PRINT(F("CO2: ")); \
+    PRINT(SAMPLE.co2ppm); \
+    PRINT(F(" ppm, temperature: ")); \
+    PRINT(SAMPLE.temperatureCentiDegrees); \
+    PRINT(F(" c°C, humidity: ")); \
+    PRINT(SAMPLE.humidityCentiPercent); \
+    PRINTLN(F(" c%")); \
+  } while (0)
+
+template <typename SensorT, typename Config>
+int16_t Clair<SensorT, Config>::getCO2Concentration() {
+  state.secondsSinceLastSample += secondsUntilNextMeasurement;
+  state.uptimeSeconds += secondsUntilNextMeasurement;
+  state.airtimeBudget.advance(secondsUntilNextMeasurement);
+
+  if (sensorSleeping) {
+    PRINTLN(F("waking up sensor"));
+    sensor->startMeasuring();
+    sensorSleeping = false;
+    secondsUntilNextMeasurement = Config::SENSOR_WARMUP_SECS;
+    return lastCO2ppm;
+  }
+
+  if (sensor->measurementFailed()) return -1;
+
+  clair_sample_t sample = sensor->sampleMeasurements();
+
+  PRINT(F("sample: "));
+  CLAIR_PRINT_SAMPLE(sample);
+
+  updateAlertState(sample);
+
+  if (SENDS_BREAKPOINTS) {
+    clair_sample_t breakpoint;
+    uint32_t breakpointTime;
+    if (state.swingingDoor.add(state.uptimeSeconds, sample, &breakpoint, &breakpointTime)) {
+      addBreakpoint(breakpoint, breakpointTime);
+    }
+  } else {
+    state.decimationFilter.add(sample);
+
+    if (state.secondsSinceLastSample >= state.samplingPeriodSeconds) {
+      clair_sample_t averageSample = state.decimationFilter.average();
+      state.decimationFilter.reset();
+      PRINT(F("average sample of sampling period: "));
+      CLAIR_PRINT_SAMPLE(averageSample);
+
+      if (state.sampleQueue.size() == 0 && isUnchanged(averageSample)) {
+        PRINTLN(F("sample unchanged since last message, not sending it"));
+      } else {
+        if (state.sampleQueue.size() == state.sampleQueue.capacity() && sampleLog != NULL) {
+          uint8_t oldestSample[Codec::SAMPLE_SIZE];
+          Codec::encodeSample(state.sampleQueue.at(0), oldestSample);
+          if (sampleLog->append(state.sampleQueue.timeAt(0), oldestSample)) {
+            PRINTLN(F("sample queue full, logged oldest sample"));
+          }
+          backfillEncoded = false;
+        }
+        if (!state.sampleQueue.push(averageSample, state.uptimeSeconds, state.samplingPeriodSeconds)) {
+          PRINTLN(F("sample queue full, discarded oldest sample"));
+        }
+        samplesEncoded = false;
+        PRINT(F("number of queued samples: "));
+        PRINTLN(state.sampleQueue.size());
+      }
+
+      state.secondsSinceLastSample = 0;
+      state.samplesAtSamplingPeriod += 1;
+      adoptSamplingPeriod();
+      alignSamplingPeriod();
+    }
+  }
+
+  planNextMeasurement();
+
+  lastCO2ppm = static_cast<int16_t>(sample.co2ppm);
+  return lastCO2ppm;
+}
+
+/*
+ * In windowed sampling mode, the measurements of a sample are spread evenly
+ * over the sampling period, the last one at its end. If the next measurement
+ * is due later than one measuring period plus the warm-up time from now, the
+ * sensor sleeps until it has to warm up for it.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::planNextMeasurement() {
+  secondsUntilNextMeasurement = Config::MEASURING_PERIOD_SECS;
+  if (state.wallClockKnown) {
+    // back on the grid after the wall-clock time has been set
+    secondsUntilNextMeasurement -= (state.uptimeSeconds + state.wallClockOffsetSeconds) % Config::MEASURING_PERIOD_SECS;
+  }
+
+  if (!Config::WINDOWED_SAMPLING || SENDS_BREAKPOINTS) return;
+
+  uint16_t period = state.samplingPeriodSeconds;
+  uint32_t nextMeasurement = static_cast<uint32_t>(state.decimationFilter.count() + 1) * period / Config::MEASUREMENTS_PER_SAMPLE;
+  nextMeasurement = std::min(nextMeasurement, static_cast<uint32_t>(period));
+  if (nextMeasurement <= static_cast<uint32_t>(state.secondsSinceLastSample + Config::MEASURING_PERIOD_SECS)) return;
+
+  secondsUntilNextMeasurement = nextMeasurement - state.secondsSinceLastSample;
+  if (secondsUntilNextMeasurement > Config::MEASURING_PERIOD_SECS + Config::SENSOR_WARMUP_SECS) {
+    PRINTLN(F("sensor going to sleep"));
+    sensor->stopMeasuring();
+    sensorSleeping = true;
+    secondsUntilNextMeasurement -= Config::SENSOR_WARMUP_SECS;
+  }
+}
+
+template <typename SensorT, typename Config>
+uint16_t Clair<SensorT, Config>::getSecondsUntilNextMeasurement() {
+  return secondsUntilNextMeasurement;
+}
+
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::setWallClockSeconds(uint32_t wallClockSeconds) {
+  uint32_t utcSeconds = wallClockSeconds - Config::GPS_UTC_OFFSET_SECS;
+  state.wallClockOffsetSeconds = utcSeconds - state.uptimeSeconds;
+  state.wallClockKnown = true;
+  state.wallClockSetSeconds = state.uptimeSeconds;
+  PRINT(F("wall-clock time [s]: ")); PRINTLN(wallClockSeconds);
+
+  uint16_t offGrid = (utcSeconds + secondsUntilNextMeasurement) % Config::MEASURING_PERIOD_SECS;
+  if (offGrid > 0) secondsUntilNextMeasurement += Config::MEASURING_PERIOD_SECS - offGrid;
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isWallClockSyncDue() {
+  return !state.wallClockKnown || state.uptimeSeconds - state.wallClockSetSeconds >= Config::WALL_CLOCK_SYNC_INTERVAL_SECS;
+}
+
+/*
+ * Like a new sampling period, a new phase takes effect once the queued
+ * samples fill whole messages, so that messages stay equispaced; the sample
+ * in progress is cut short or extended. This also holds for a sample that
+ * ended a little late, e.g., because the sensor had to warm up after a new
+ * phase; the samples after it keep its phase up to the end of the message.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::alignSamplingPeriod() {
+  if (!state.wallClockKnown) return;
+  if (state.sampleQueue.size() > 0 && state.samplesAtSamplingPeriod % transmissionConfig.samplesPerMessage != 0) return;
+
+  state.secondsSinceLastSample = (state.uptimeSeconds + state.wallClockOffsetSeconds) % state.samplingPeriodSeconds;
+}
+
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::setCurrentDatarate(int datarate) {
+  if (datarate < 0 || datarate >= CLAIR_NROF_DATARATES) {
+    PRINT(F("WARNING: invalid datarate: ")); PRINTLN(datarate);
+    datarate = 0;
+  }
+
+  state.currentDatarate = datarate;
+  planTransmission();
+  adoptSamplingPeriod();
+
+  PRINT(F("current datarate: "));
+  PRINT_DATARATE(state.currentDatarate);
+  PRINTLN("");
+  PRINT(F("current sampling period [s]: ")); PRINTLN(state.samplingPeriodSeconds);
+  PRINT(F("planned sampling period [s]: ")); PRINTLN(transmissionConfig.samplingPeriodSeconds);
+  PRINT(F("current # of samples in message: ")); PRINTLN(transmissionConfig.samplesPerMessage);
+  PRINT(F("airtime used in last 24h [ms]: ")); PRINTLN(state.airtimeBudget.usedUs() / 1000);
+}
+
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::saveState(State *savedState) {
+  *savedState = state;
+  savedState->numberOfLoggedSamples = sampleLog != NULL ? sampleLog->size() : 0;
+}
+
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::restoreState(const State &savedState) {
+  state = savedState;
+  // off by the time spent in the reset, so that it is due to be set again
+  state.wallClockSetSeconds = state.uptimeSeconds - Config::WALL_CLOCK_SYNC_INTERVAL_SECS;
+  if (sampleLog != NULL) sampleLog->keepNewest(state.numberOfLoggedSamples);
+  samplesEncoded = false;
+  backfillEncoded = false;
+
+  // the sensor has just been set up and measures again
+  secondsUntilNextMeasurement = Config::MEASURING_PERIOD_SECS;
+  sensorSleeping = false;
+  encodedLength = 0;
+
+  planTransmission();
+
+  PRINT(F("restored state, number of queued samples: "));
+  PRINTLN(state.sampleQueue.size());
+}
+
+/*
+ * Encodes the oldest queued samples of the same sampling period, up to a full
+ * message, plainly, as deltas, or Rice coded, whichever is shortest. Plain and delta encoding hold
+ * at most CLAIR_MAX_NROF_SAMPLES_IN_HEADER samples; if the Rice codes of more
+ * samples do not fit, only the oldest ones are encoded plainly.
+ */
+template <typename SensorT, typename Config>
+clair_encoding_t Clair<SensorT, Config>::encodeSamples(uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  uint8_t numberOfSamples = state.sampleQueue.copyOldest(sampleBuffer,
+      std::min(state.sampleQueue.countEquispaced(), static_cast<uint8_t>(Config::MAX_NROF_SAMPLES_PER_MESSAGE)));
+  bool fitsHeader = numberOfSamples <= CLAIR_MAX_NROF_SAMPLES_IN_HEADER;
+
+  uint8_t plainLength = fitsHeader ? numberOfSamples * Codec::SAMPLE_SIZE : 0;
+  if (plainLength > messageBufferSize) plainLength = 0;
+  uint8_t deltaMessage[MAX_MESSAGE_SIZE];
+  uint8_t deltaLength = fitsHeader ? Codec::encodeDeltaSamples(sampleBuffer, numberOfSamples,
+      deltaMessage, std::min(messageBufferSize, static_cast<uint16_t>(sizeof(deltaMessage)))) : 0;
+  uint8_t riceHeader = 0;
+  uint8_t riceLength = Codec::encodeRiceSamples(sampleBuffer, numberOfSamples, messageBuffer, messageBufferSize, &riceHeader);
+
+  // the shortest encoding wins, the simpler one on ties
+  clair_encoding_t encoding = { CLAIR_MESSAGE_ID_SAMPLE_LIST, static_cast<uint8_t>(numberOfSamples - 1), numberOfSamples, plainLength };
+  if (deltaLength > 0 && (encoding.length == 0 || deltaLength < encoding.length)) {
+    encoding.messageId = CLAIR_MESSAGE_ID_DELTA_LIST;
+    encoding.length = deltaLength;
+  }
+  if (riceLength > 0 && (encoding.length == 0 || riceLength < encoding.length)) {
+    encoding.messageId = CLAIR_MESSAGE_ID_RICE_LIST;
+    encoding.messageHeader = riceHeader;
+    encoding.length = riceLength;
+  }
+
+  if (encoding.length == 0) {
+    PRINTLN(F("WARNING: samples do not fit into the message, sending the oldest ones"));
+    encoding.numberOfSamples = std::min(numberOfSamples, static_cast<uint8_t>(CLAIR_MAX_NROF_SAMPLES_IN_HEADER));
+    encoding.messageHeader = encoding.numberOfSamples - 1;
+    encoding.length = encoding.numberOfSamples * Codec::SAMPLE_SIZE;
+    if (encoding.length > messageBufferSize) {
+      encoding.length = 0;
+      return encoding;
+    }
+  }
+
+  // the buffer holds the Rice codes, the deltas were encoded aside
+  if (encoding.messageId == CLAIR_MESSAGE_ID_DELTA_LIST) {
+    memcpy(messageBuffer, deltaMessage, deltaLength);
+  } else if (encoding.messageId == CLAIR_MESSAGE_ID_SAMPLE_LIST) {
+    for (int i = 0; i < encoding.numberOfSamples; i++) {
+      Codec::encodeSample(sampleBuffer[i], messageBuffer + i * Codec::SAMPLE_SIZE);
+    }
+  }
+
+  return encoding;
+}
+
+/*
+ * isMessageDue() and encodeMessage() are called several times per
+ * measurement and send attempt, so the samples are only encoded again once
+ * the queue has changed.
+ */
+template <typename SensorT, typename Config>
+const clair_encoding_t &Clair<SensorT, Config>::pendingSamples() {
+  if (!samplesEncoded) {
+    samplesEncoding = encodeSamples(samplesMessage, sizeof(samplesMessage));
+    samplesEncoded = true;
+  }
+  return samplesEncoding;
+}
+
+/*
+ * Samples of different sampling periods cannot share a message, so those of
+ * the previous period are sent even if they do not fill a message.
+ */
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::hasSamplingPeriodChanged() {
+  return state.sampleQueue.countEquispaced() < state.sampleQueue.size();
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isMessageDue() {
+  if (SENDS_BREAKPOINTS) return isBreakpointMessageDue();
+  if (state.sampleQueue.size() < transmissionConfig.samplesPerMessage && !hasSamplingPeriodChanged()) {
+    return isBackfillDue() || (state.sampleQueue.size() == 0 && isHeartbeatDue());
+  }
+
+  const clair_encoding_t &encoding = pendingSamples();
+  uint8_t ageSize = encodeSampleAge(state.uptimeSeconds - state.sampleQueue.timeAt(encoding.numberOfSamples - 1), nullptr);
+
+  uint32_t airtime = airtimeOfUplinkUs(state.currentDatarate, CLAIR_HEADER_SIZE + encoding.length + ageSize);
+  return state.airtimeBudget.allows(airtime);
+}
+
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::encodeMessage(uint8_t *messageBuffer, uint16_t messageBufferSize,
+    uint16_t secondsSinceMeasurement) {
+  if (!isMessageDue()) return 0;
+  if (messageBufferSize < CLAIR_HEADER_SIZE) return 0;
+  if (SENDS_BREAKPOINTS) return encodeBreakpointMessage(messageBuffer, messageBufferSize);
+  if (state.sampleQueue.size() < transmissionConfig.samplesPerMessage && !hasSamplingPeriodChanged()) {
+    if (!isBackfillDue()) return encodeHeartbeat(messageBuffer, messageBufferSize);
+
+    clair_encoding_t encoding = pendingBackfill();
+    if (encoding.length == 0 || encoding.length > messageBufferSize) return 0;
+    memcpy(messageBuffer, backfillMessage, encoding.length);
+
+    uint32_t age = (state.uptimeSeconds - backfillLastTime + CLAIR_BACKFILL_AGE_UNIT_SECS / 2) / CLAIR_BACKFILL_AGE_UNIT_SECS;
+    age = std::min(age, static_cast<uint32_t>(UINT16_MAX));
+    messageBuffer[2] = age >> 8;
+    messageBuffer[3] = age & 0xFF;
+
+    encodedMessageId = encoding.messageId;
+    encodedNumberOfSamples = encoding.numberOfSamples;
+    encodedLength = encoding.length;
+    encodedSampleAgeSeconds = age * CLAIR_BACKFILL_AGE_UNIT_SECS;
+    return encoding.length;
+  }
+  const clair_encoding_t &encoding = pendingSamples();
+  if (encoding.length == 0 || messageBufferSize < CLAIR_HEADER_SIZE + encoding.length + CLAIR_SAMPLE_AGE_MAX_SIZE) return 0;
+  memcpy(messageBuffer + CLAIR_HEADER_SIZE, samplesMessage, encoding.length);
+
+  // encode header
+  messageBuffer[0] = 0;
+  messageBuffer[0] |= CLAIR_PROTOCOL_VERSION << 6; // protocol version (2 bits)
+  messageBuffer[0] |= encoding.messageId << 3; // message identifier (3 bits)
+  // NOTE: sample lists transmit the number of samples - 1 to use all bits of the message header to full capacity!
+  messageBuffer[0] |= encoding.messageHeader; // message header (3 bits)
+
+  // sampling period in units of Config::SAMPLING_PERIOD_UNIT_SECS (1 byte)
+  uint16_t samplingPeriod = state.sampleQueue.samplingPeriodAt(0);
+  messageBuffer[1] = samplingPeriod / Config::SAMPLING_PERIOD_UNIT_SECS;
+
+  uint8_t messageLength = CLAIR_HEADER_SIZE + encoding.length;
+
+  // the age of the last sample at transmission, so that the server can tell the time of the samples even if they
+  // were queued; omitted for the newest sample, which is taken right before transmission
+  uint32_t ageSeconds = state.uptimeSeconds - state.sampleQueue.timeAt(encoding.numberOfSamples - 1) + secondsSinceMeasurement;
+  if (ageSeconds > 0) {
+    PRINT(F("age of the last sample [s]: ")); PRINTLN(ageSeconds);
+  }
+  messageLength += encodeSampleAge(ageSeconds, messageBuffer + messageLength);
+
+  if (encoding.numberOfSamples > 1) {
+    if (encoding.messageId == CLAIR_MESSAGE_ID_SAMPLE_LIST) {
+      state.expectedBitsPerDelta = Codec::SAMPLE_SIZE * 8;
+    } else {
+      uint16_t deltaBits = (encoding.length - Codec::compressedSamplesSize(1, 0)) * 8;
+      state.expectedBitsPerDelta = (deltaBits + encoding.numberOfSamples - 2) / (encoding.numberOfSamples - 1);
+    }
+  }
+
+  encodedMessageId = encoding.messageId;
+  encodedNumberOfSamples = encoding.numberOfSamples;
+  encodedLength = messageLength;
+  encodedSampleAgeSeconds = state.uptimeSeconds - state.sampleQueue.timeAt(encoding.numberOfSamples - 1);
+
+  return messageLength;
+}
+
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::encodeSampleAge(uint32_t ageSeconds, uint8_t *messageBuffer) {
+  if (ageSeconds == 0) return 0;
+  if (ageSeconds <= CLAIR_SAMPLE_AGE_SHORT_MAX_SECS) {
+    if (messageBuffer) messageBuffer[0] = ageSeconds;
+    return 1;
+  }
+
+  uint16_t age = 0x8000 | ageSeconds;
+  if (ageSeconds > CLAIR_SAMPLE_AGE_FINE_MAX_SECS) {
+    // a sample older than the field can tell is marked as such rather than dated wrongly
+    uint16_t units = ageSeconds > CLAIR_SAMPLE_AGE_MAX_SECS ? CLAIR_SAMPLE_AGE_SATURATED
+      : (ageSeconds + CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS / 2) / CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS;
+    age = 0xC000 | units;
+  }
+  if (messageBuffer) {
+    messageBuffer[0] = age >> 8;
+    messageBuffer[1] = age & 0xFF;
+  }
+  return 2;
+}
+
+template <typename SensorT, typename Config>
+uint32_t Clair<SensorT, Config>::getEncodedSampleAgeSeconds() {
+  return encodedSampleAgeSeconds;
+}
+
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::commitMessage() {
+  if (encodedLength == 0) return;
+
+  if (encodedMessageId == CLAIR_MESSAGE_ID_ALERT) {
+    state.reportedAirQuality = Display::concentrationToAirQuality(state.latestSample.co2ppm);
+    state.trendAlertPending = false;
+    state.alertSent = true;
+    state.lastAlertSeconds = state.uptimeSeconds;
+  } else if (encodedMessageId == CLAIR_MESSAGE_ID_BREAKPOINT_LIST) {
+    Codec::encodeSample(state.breakpoints[encodedNumberOfSamples - 1], state.lastTransmittedSample);
+    state.lastTransmittedBreakpointTime = state.breakpointTimes[encodedNumberOfSamples - 1];
+    state.numberOfBreakpoints -= encodedNumberOfSamples;
+    for (int i = 0; i < state.numberOfBreakpoints; i++) {
+      state.breakpoints[i] = state.breakpoints[i + encodedNumberOfSamples];
+      state.breakpointTimes[i] = state.breakpointTimes[i + encodedNumberOfSamples];
+    }
+  } else if (encodedMessageId == CLAIR_MESSAGE_ID_BACKFILL_LIST) {
+    if (sampleLog != NULL) sampleLog->discardOldest(encodedNumberOfSamples);
+    backfillEncoded = false;
+  } else if (encodedMessageId != CLAIR_MESSAGE_ID_HEARTBEAT) {
+    Codec::encodeSample(state.sampleQueue.at(encodedNumberOfSamples - 1), state.lastTransmittedSample);
+    state.sampleQueue.discardOldest(encodedNumberOfSamples);
+    samplesEncoded = false;
+  }
+  if (encodedNumberOfSamples > 0 && encodedMessageId != CLAIR_MESSAGE_ID_BACKFILL_LIST) state.sampleTransmitted = true;
+  // alerts do not stand in for heartbeats, which tell that the samples are unchanged
+  if (encodedMessageId != CLAIR_MESSAGE_ID_ALERT) state.lastMessageSeconds = state.uptimeSeconds;
+
+  state.airtimeBudget.charge(airtimeOfUplinkUs(state.currentDatarate, encodedLength));
+  encodedLength = 0;
+  planTransmission();
+  adoptSamplingPeriod();
+}
+
+/*
+ * A newly planned sampling period takes effect once the samples taken at the
+ * current one fill whole messages, or have all been sent, so that messages
+ * stay equispaced without being cut short.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::adoptSamplingPeriod() {
+  if (state.samplingPeriodSeconds == transmissionConfig.samplingPeriodSeconds) return;
+  if (state.sampleQueue.size() > 0 && state.samplesAtSamplingPeriod % transmissionConfig.samplesPerMessage != 0) return;
+
+  state.samplingPeriodSeconds = transmissionConfig.samplingPeriodSeconds;
+  state.samplesAtSamplingPeriod = 0;
+  PRINT(F("new sampling period [s]: ")); PRINTLN(state.samplingPeriodSeconds);
+  alignSamplingPeriod();
+}
+
+/*
+ * If a message is overdue and the buffer is full, the oldest breakpoint is
+ * discarded.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::addBreakpoint(clair_sample_t breakpoint, uint32_t time) {
+  PRINT(F("breakpoint: "));
+  CLAIR_PRINT_SAMPLE(breakpoint);
+
+  if (state.numberOfBreakpoints == CLAIR_MAX_NROF_SAMPLES_IN_HEADER) {
+    PRINTLN(F("message overdue, discarding oldest breakpoint"));
+    for (int i = 0; i < state.numberOfBreakpoints - 1; i++) {
+      state.breakpoints[i] = state.breakpoints[i + 1];
+      state.breakpointTimes[i] = state.breakpointTimes[i + 1];
+    }
+    state.numberOfBreakpoints -= 1;
+  }
+
+  state.breakpoints[state.numberOfBreakpoints] = breakpoint;
+  state.breakpointTimes[state.numberOfBreakpoints] = time;
+  state.numberOfBreakpoints += 1;
+}
+
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::breakpointMessageSize(uint8_t numberOfBreakpoints) {
+  return CLAIR_HEADER_SIZE + numberOfBreakpoints * (CLAIR_BREAKPOINT_OFFSET_SIZE + Codec::SAMPLE_SIZE);
+}
+
+/*
+ * The latest reading is sent as the last breakpoint, so a message is due as
+ * soon as the hourly airtime allowance covers it since the last message. A
+ * full message is sent whenever the daily budget allows.
+ */
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isBreakpointMessageDue() {
+  uint8_t numberOfMessageBreakpoints = state.numberOfBreakpoints;
+  if (numberOfMessageBreakpoints < CLAIR_MAX_NROF_SAMPLES_IN_HEADER && state.swingingDoor.hasPendingReadings()) {
+    numberOfMessageBreakpoints += 1;
+  }
+  if (numberOfMessageBreakpoints == 0) return false;
+
+  // flat stretches are only sent as heartbeats
+  bool unchanged = isUnchanged(state.latestSample);
+  for (int i = 0; i < state.numberOfBreakpoints; i++) unchanged = unchanged && isUnchanged(state.breakpoints[i]);
+  if (unchanged && state.uptimeSeconds - state.lastMessageSeconds < Config::HEARTBEAT_INTERVAL_SECS) return false;
+
+  uint32_t airtime = airtimeOfUplinkUs(state.currentDatarate, breakpointMessageSize(numberOfMessageBreakpoints));
+  if (!state.airtimeBudget.allows(airtime)) return false;
+  if (numberOfMessageBreakpoints == CLAIR_MAX_NROF_SAMPLES_IN_HEADER) return true;
+
+  uint32_t allowance = state.airtimeBudget.allowanceUsPerHour();
+  if (allowance == 0) return false;
+  uint64_t transmissionInterval = static_cast<uint64_t>(airtime) * AIRTIME_BUDGET_SLOT_SECS / allowance;
+  return state.uptimeSeconds - state.lastMessageSeconds >= transmissionInterval;
+}
+
+// offset between two breakpoint times in units of CLAIR_BREAKPOINT_OFFSET_UNIT_SECS, saturated
+static inline uint8_t clairBreakpointOffset(uint32_t from, uint32_t to) {
+  uint32_t offset = (to - from) / CLAIR_BREAKPOINT_OFFSET_UNIT_SECS;
+  return offset > UINT8_MAX ? UINT8_MAX : offset;
+}
+
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::encodeBreakpointMessage(uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  clair_sample_t breakpoint;
+  uint32_t breakpointTime;
+  if (state.numberOfBreakpoints < CLAIR_MAX_NROF_SAMPLES_IN_HEADER && state.swingingDoor.flush(&breakpoint, &breakpointTime)) {
+    addBreakpoint(breakpoint, breakpointTime);
+  }
+
+  uint8_t messageLength = breakpointMessageSize(state.numberOfBreakpoints);
+  if (messageLength > messageBufferSize) return 0;
+
+  messageBuffer[0] = 0;
+  messageBuffer[0] |= CLAIR_PROTOCOL_VERSION << 6;
+  messageBuffer[0] |= CLAIR_MESSAGE_ID_BREAKPOINT_LIST << 3;
+  messageBuffer[0] |= state.numberOfBreakpoints - 1;
+
+  // age of the last breakpoint
+  messageBuffer[1] = clairBreakpointOffset(state.breakpointTimes[state.numberOfBreakpoints - 1], state.uptimeSeconds);
+
+  // each breakpoint follows its offset to the previous one, the first to the last one of the previous message
+  uint32_t previousTime = state.lastTransmittedBreakpointTime;
+  uint8_t *position = messageBuffer + CLAIR_HEADER_SIZE;
+  for (int i = 0; i < state.numberOfBreakpoints; i++) {
+    position[0] = clairBreakpointOffset(previousTime, state.breakpointTimes[i]);
+    Codec::encodeSample(state.breakpoints[i], position + CLAIR_BREAKPOINT_OFFSET_SIZE);
+    position += CLAIR_BREAKPOINT_OFFSET_SIZE + Codec::SAMPLE_SIZE;
+    previousTime = state.breakpointTimes[i];
+  }
+
+  encodedMessageId = CLAIR_MESSAGE_ID_BREAKPOINT_LIST;
+  encodedNumberOfSamples = state.numberOfBreakpoints;
+  encodedLength = messageLength;
+  encodedSampleAgeSeconds = state.uptimeSeconds - state.breakpointTimes[state.numberOfBreakpoints - 1];
+
+  return messageLength;
+}
+
+/*
+ * Encodes a backfill list of the oldest logged samples that are equispaced,
+ * Rice coded. The sampling period is the interval between them, 0 for a
+ * single sample. The length covers the entire message. The age, which is
+ * left out, refers to backfillLastTime.
+ */
+template <typename SensorT, typename Config>
+clair_encoding_t Clair<SensorT, Config>::encodeBackfill(uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  const uint8_t headerSize = CLAIR_HEADER_SIZE + CLAIR_BACKFILL_AGE_SIZE;
+  clair_encoding_t encoding = { CLAIR_MESSAGE_ID_BACKFILL_LIST, 0, 0, 0 };
+  if (messageBufferSize < headerSize) return encoding;
+
+  sample_log_record_t record;
+  if (!sampleLog->read(0, &record)) return encoding;
+  sampleBuffer[0] = Codec::decodeSample(record.sample);
+  uint32_t firstTime = record.time;
+  uint32_t lastTime = record.time;
+  uint32_t period = 0;
+
+  uint8_t numberOfSamples = 1;
+  while (numberOfSamples < Config::MAX_NROF_SAMPLES_PER_MESSAGE && sampleLog->read(numberOfSamples, &record)) {
+    if (numberOfSamples == 1) period = record.time - firstTime;
+    if (record.time - lastTime != period) break;
+    if (period == 0 || period % Config::SAMPLING_PERIOD_UNIT_SECS != 0
+        || period / Config::SAMPLING_PERIOD_UNIT_SECS > UINT8_MAX) break;
+
+    sampleBuffer[numberOfSamples] = Codec::decodeSample(record.sample);
+    lastTime = record.time;
+    numberOfSamples += 1;
+  }
+  if (numberOfSamples == 1) period = 0;
+
+  // large deltas may not fit; a single sample always does
+  uint8_t length;
+  while ((length = Codec::encodeRiceSamples(sampleBuffer, numberOfSamples, messageBuffer + headerSize,
+      messageBufferSize - headerSize, &encoding.messageHeader)) == 0) {
+    if (numberOfSamples == 1) return encoding;
+    numberOfSamples -= 1;
+    lastTime -= period;
+  }
+
+  messageBuffer[0] = 0;
+  messageBuffer[0] |= CLAIR_PROTOCOL_VERSION << 6;
+  messageBuffer[0] |= CLAIR_MESSAGE_ID_BACKFILL_LIST << 3;
+  messageBuffer[0] |= encoding.messageHeader;
+  messageBuffer[1] = period / Config::SAMPLING_PERIOD_UNIT_SECS;
+
+  backfillLastTime = lastTime;
+  encoding.numberOfSamples = numberOfSamples;
+  encoding.length = headerSize + length;
+  return encoding;
+}
+
+/*
+ * Reading and encoding the logged samples takes a while, so it is done once
+ * per change of the log rather than on each measurement.
+ */
+template <typename SensorT, typename Config>
+const clair_encoding_t &Clair<SensorT, Config>::pendingBackfill() {
+  if (!backfillEncoded) {
+    backfillEncoding = encodeBackfill(backfillMessage, sizeof(backfillMessage));
+    backfillEncoded = true;
+  }
+  return backfillEncoding;
+}
+
+/*
+ * Backfill lists only spend the part of the hourly allowance that the
+ * planned messages leave unused, e.g., because the sampling period is at its
+ * minimum, so that they do not lower the resolution of live samples.
+ */
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isBackfillDue() {
+  if (sampleLog == NULL || sampleLog->size() == 0) return false;
+
+  const clair_encoding_t &encoding = pendingBackfill();
+  if (encoding.length == 0) return false;
+
+  uint32_t plannedAirtime = airtimeOfUplinkUs(state.currentDatarate, plannedMessageSize(transmissionConfig.samplesPerMessage));
+  uint32_t plannedAirtimePerHour = static_cast<uint64_t>(plannedAirtime) * AIRTIME_BUDGET_SLOT_SECS
+    / (static_cast<uint32_t>(transmissionConfig.samplingPeriodSeconds) * transmissionConfig.samplesPerMessage);
+
+  uint32_t airtime = airtimeOfUplinkUs(state.currentDatarate, encoding.length);
+  return state.airtimeBudget.allows(airtime) && plannedAirtimePerHour + airtime <= state.airtimeBudget.allowanceUsPerHour();
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isUnchanged(clair_sample_t sample) {
+  if (Config::HEARTBEAT_INTERVAL_SECS == 0 || !state.sampleTransmitted) return false;
+
+  return Codec::encodesLike(sample, state.lastTransmittedSample);
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isHeartbeatDue() {
+  if (Config::HEARTBEAT_INTERVAL_SECS == 0 || !state.sampleTransmitted) return false;
+  if (state.uptimeSeconds - state.lastMessageSeconds < Config::HEARTBEAT_INTERVAL_SECS) return false;
+
+  return state.airtimeBudget.allows(airtimeOfUplinkUs(state.currentDatarate, HEARTBEAT_MESSAGE_SIZE));
+}
+
+/*
+ * A heartbeat tells the server that the node is alive and that the samples
+ * since the last message are unchanged.
+ */
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::encodeHeartbeat(uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  if (messageBufferSize < HEARTBEAT_MESSAGE_SIZE) return 0;
+
+  PRINTLN(F("samples unchanged, sending heartbeat"));
+
+  messageBuffer[0] = 0;
+  messageBuffer[0] |= CLAIR_PROTOCOL_VERSION << 6;
+  messageBuffer[0] |= CLAIR_MESSAGE_ID_HEARTBEAT << 3;
+  messageBuffer[1] = transmissionConfig.samplingPeriodSeconds / Config::SAMPLING_PERIOD_UNIT_SECS;
+
+  encodedMessageId = CLAIR_MESSAGE_ID_HEARTBEAT;
+  encodedNumberOfSamples = 0;
+  encodedLength = HEARTBEAT_MESSAGE_SIZE;
+  encodedSampleAgeSeconds = 0;
+
+  return HEARTBEAT_MESSAGE_SIZE;
+}
+
+/*
+ * The trend is the change of the CO2 concentration over the last
+ * Config::ALERT_TREND_WINDOW_SECS or more, which averages out the noise of
+ * the readings. A trend alert is raised when the trend becomes steep.
+ */
+template <typename SensorT, typename Config>
+void Clair<SensorT, Config>::updateAlertState(clair_sample_t sample) {
+  bool firstReading = state.trendReferenceSeconds == 0;
+  state.latestSample = sample;
+
+  if (firstReading) {
+    state.reportedAirQuality = Display::concentrationToAirQuality(sample.co2ppm);
+  } else {
+    uint32_t secondsSinceReference = state.uptimeSeconds - state.trendReferenceSeconds;
+    if (secondsSinceReference < Config::ALERT_TREND_WINDOW_SECS) return;
+
+    int32_t trend = (static_cast<int32_t>(sample.co2ppm) - state.trendReferenceCO2ppm) * 60
+      / static_cast<int32_t>(secondsSinceReference);
+    state.co2TrendPpmPerMinute = std::max(std::min(trend, static_cast<int32_t>(INT16_MAX)), static_cast<int32_t>(INT16_MIN));
+
+    uint16_t steepness = state.co2TrendPpmPerMinute < 0 ? -state.co2TrendPpmPerMinute : state.co2TrendPpmPerMinute;
+    bool steep = Config::ALERT_TREND_PPM_PER_MINUTE > 0 && steepness >= Config::ALERT_TREND_PPM_PER_MINUTE;
+    if (steep && !state.steepTrend) {
+      PRINT(F("steep CO2 trend [ppm/min]: ")); PRINTLN(state.co2TrendPpmPerMinute);
+      state.trendAlertPending = true;
+    }
+    state.steepTrend = steep;
+  }
+
+  state.trendReferenceCO2ppm = sample.co2ppm;
+  state.trendReferenceSeconds = state.uptimeSeconds;
+}
+
+/*
+ * The category only counts as changed if it does not change within
+ * Config::AIR_QUALITY_HYSTERESIS_PPM, so that readings close to a threshold
+ * do not raise alerts over and over.
+ */
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::hasAirQualityChanged() {
+  if (state.trendReferenceSeconds == 0) return false;
+
+  uint16_t co2ppm = state.latestSample.co2ppm;
+  uint16_t hysteresis = Config::AIR_QUALITY_HYSTERESIS_PPM;
+  CO2AirQuality lower = Display::concentrationToAirQuality(co2ppm > hysteresis ? co2ppm - hysteresis : 0);
+  CO2AirQuality upper = Display::concentrationToAirQuality(co2ppm + hysteresis);
+  return lower == upper && lower != state.reportedAirQuality;
+}
+
+template <typename SensorT, typename Config>
+bool Clair<SensorT, Config>::isAlertDue() {
+  if (!hasAirQualityChanged() && !state.trendAlertPending) return false;
+  if (state.alertSent && state.uptimeSeconds - state.lastAlertSeconds < Config::MIN_ALERT_INTERVAL_SECS) return false;
+
+  return state.airtimeBudget.allows(airtimeOfUplinkUs(state.currentDatarate, ALERT_MESSAGE_SIZE));
+}
+
+template <typename SensorT, typename Config>
+uint8_t Clair<SensorT, Config>::encodeAlert(uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  if (!isAlertDue()) return 0;
+  if (messageBufferSize < ALERT_MESSAGE_SIZE) return 0;
+
+  CO2AirQuality airQuality = Display::concentrationToAirQuality(state.latestSample.co2ppm);
+  PRINT(F("alert, air quality: ")); PRINTLN(static_cast<uint8_t>(airQuality));
+
+  messageBuffer[0] = 0;
+  messageBuffer[0] |= CLAIR_PROTOCOL_VERSION << 6;
+  messageBuffer[0] |= CLAIR_MESSAGE_ID_ALERT << 3;
+  messageBuffer[0] |= static_cast<uint8_t>(airQuality);
+
+  // CO2 trend (1 signed byte)
+  int16_t trend = state.co2TrendPpmPerMinute / CLAIR_ALERT_TREND_UNIT_PPM_PER_MINUTE;
+  trend = std::max(std::min(trend, static_cast<int16_t>(INT8_MAX)), static_cast<int16_t>(INT8_MIN));
+  messageBuffer[1] = static_cast<uint8_t>(trend);
+
+  Codec::encodeSample(state.latestSample, messageBuffer + CLAIR_HEADER_SIZE);
+
+  encodedMessageId = CLAIR_MESSAGE_ID_ALERT;
+  encodedNumberOfSamples = 0;
+  encodedLength = ALERT_MESSAGE_SIZE;
+  encodedSampleAgeSeconds = 0;
+
+  return ALERT_MESSAGE_SIZE;
+}
+
+#endif /* CLAIR_IMPL_H */
@@ -0,0 +1,53 @@
+#ifndef CLAIR_PROTOCOL_H
+#define CLAIR_PROTOCOL_H
+
+/*
+ * Uplink message format, see docs/message-format.md
+ */
+
+/* sizes in bytes; the header is followed by the sampling period */
+#define CLAIR_HEADER_SIZE 2
+
+/* the sampling period is given in this unit (1 byte) */
+#define CLAIR_SAMPLING_PERIOD_UNIT_SECS 5
+
+#define CLAIR_PROTOCOL_VERSION 2
+#define CLAIR_MESSAGE_ID_SAMPLE_LIST 0
+#define CLAIR_MESSAGE_ID_DELTA_LIST 1
+#define CLAIR_MESSAGE_ID_RICE_LIST 2
+#define CLAIR_MESSAGE_ID_BREAKPOINT_LIST 3
+#define CLAIR_MESSAGE_ID_ALERT 4
+#define CLAIR_MESSAGE_ID_HEARTBEAT 5
+#define CLAIR_MESSAGE_ID_BACKFILL_LIST 6
+
+/* version 1 sample lists sent from a backlog end with the number of samples queued after them (1 byte) */
+#define CLAIR_BACKLOG_SIZE 1
+
+/*
+ * version 2 sample lists end with the age of their last sample at transmission, unless it is 0:
+ * 1 byte (0xxxxxxx) up to 127 s, 2 bytes (10xxxxxx xxxxxxxx, MSB first) up to 16383 s, and 2 bytes
+ * (11xxxxxx xxxxxxxx) in units of CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS beyond; the largest coarse value
+ * marks an age too old to tell, which the decoder rejects
+ */
+#define CLAIR_SAMPLE_AGE_MAX_SIZE 2
+#define CLAIR_SAMPLE_AGE_SHORT_MAX_SECS 0x7F
+#define CLAIR_SAMPLE_AGE_FINE_MAX_SECS 0x3FFF
+#define CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS 5
+#define CLAIR_SAMPLE_AGE_SATURATED 0x3FFF
+#define CLAIR_SAMPLE_AGE_MAX_SECS (CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS * (CLAIR_SAMPLE_AGE_SATURATED - 1))
+
+/* backfill lists give the age of their last sample in this unit (2 bytes, MSB first) */
+#define CLAIR_BACKFILL_AGE_UNIT_SECS 60
+#define CLAIR_BACKFILL_AGE_SIZE 2
+
+/* the message-specific header of plain and delta sample lists holds the number of samples - 1 */
+#define CLAIR_MAX_NROF_SAMPLES_IN_HEADER 8
+
+/* breakpoint lists give times as 1-byte offsets in this unit */
+#define CLAIR_BREAKPOINT_OFFSET_UNIT_SECS 5
+#define CLAIR_BREAKPOINT_OFFSET_SIZE 1
+
+/* alerts hold the air quality in the message-specific header and the CO2 trend in this unit (1 signed byte) */
+#define CLAIR_ALERT_TREND_UNIT_PPM_PER_MINUTE 10
+
+#endif /* CLAIR_PROTOCOL_H */
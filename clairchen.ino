@@ -1,18 +1,69 @@
 #include "scd30_sensor.h"
 #include "clair.h"
-#include "blinking_display.h"
+#include "clairchen_config.h"
+#include "flash_log_storage.h"
+#include "sample_log.h"
+#include "hardware_blinking_display.h"
+#include "tcc_led_timer.h"
 #include "things_network.h"
+#include "retained_state.h"
+#include "transmission_jitter.h"
+#include "standby.h"
+#include "timer_service.h"
 #include "error_code.h"
 #include "debug.h"
 #include <arduino_lmic.h>
 #include <arduino_lmic_hal_boards.h>
 
 static ErrorCode errorCode;
-static osjob_t clairjob;
+static void measureAndSendIfDue(void *context);
+static void sendWhenPossible(void *context);
+static TimerService timers;
+static Timer measurementTimer(measureAndSendIfDue, NULL);
+static Timer sendTimer(sendWhenPossible, NULL);
 static Scd30Sensor sensor;
-static Clair clair(&sensor);
-static BlinkingDisplay display;
+// the reserved flash holds the sample log, followed by checkpoints of the LoRaWAN session
+#define SESSION_STORE_ROWS 4
+#define SAMPLE_LOG_ROWS (FLASH_LOG_STORAGE_SIZE / FLASH_LOG_STORAGE_ROW_SIZE - SESSION_STORE_ROWS)
+
+// longer than a measurement takes, with its I2C transfers and Serial output
+#define MEASUREMENT_MAX_MILLIS 100
+// how late jobs may run, so that they can share a wakeup with others
+#define MEASUREMENT_TOLERANCE_MILLIS 100
+#define SEND_TOLERANCE_MILLIS 1000
+
+static FlashLogStorage sampleLogStorage(0, SAMPLE_LOG_ROWS);
+static SampleLog sampleLog(&sampleLogStorage);
+static FlashLogStorage sessionStorage(SAMPLE_LOG_ROWS, SESSION_STORE_ROWS);
+static SessionStore sessionStore(&sessionStorage);
+static Clair<Scd30Sensor, ClairchenConfig> clair(&sensor, &sampleLog);
+// survives watchdog and brownout resets, so that queued samples are not lost
+static RetainedState<Clair<Scd30Sensor, ClairchenConfig>::State> retainedState RETAINED_STATE_NOINIT;
+static TccLedTimer ledTimer;
+static HardwareBlinkingDisplay display(&ledTimer);
+#if CLAIR_DEEP_SLEEP
+static Standby standby;
+#endif
 static bool joined;
+// to tell the age of the newest sample of an uplink when it goes on air
+static ostime_t lastMeasurementTime;
+static uint32_t encodedSampleAgeSeconds;
+// when the next measurement is scheduled, relative to the previous one so that Clair's clock does not drift
+static ostime_t nextMeasurementTime;
+static bool networkTimeRequested;
+static TransmissionJitter transmissionJitter;
+// a pending send is only ever moved to an earlier time
+static ostime_t scheduledSendTime;
+
+static void scheduleSendIfDue();
+static void sendIfDue();
+static void scheduleSend(ostime_t time);
+static void onNetworkTime(void *userData, int success);
+#if CLAIR_DEEP_SLEEP
+static void sleepUntilNextJob();
+#endif
+static bool isWarmReset();
+static void retainState();
 
 #define ERROR(ERROR_CODE) do { \
     errorCode = ERROR_CODE; \
@@ -26,37 +77,92 @@ void setup() {
 
   Wire.begin();
   display.setup();
+#if CLAIR_DEEP_SLEEP
+  if (!standby.begin()) {
+    PRINTLN(F("WARNING: standby not available"));
+  }
+#endif
+  if (!sampleLog.begin()) {
+    PRINTLN(F("WARNING: sample log not available"));
+  }
   if (!clair.setup()) {
     ERROR(ErrorCode::CLAIR_SETUP_FAILED);
   }
 
   LMIC_reset();
 
+  uint8_t devEui[TRANSMISSION_JITTER_DEVEUI_SIZE];
+  os_getDevEui(devEui);
+  transmissionJitter.begin(devEui);
+
+  if (!sessionStore.begin()) {
+    PRINTLN(F("WARNING: session store not available"));
+  }
+
+  if (restoreSession(&sessionStore)) {
+    joined = true;
+  } else {
 #if 1
-  resumeConnection();
-  LMIC_setDrTxpow(DR_SF8, 14);
-  joined = true;
-  // LMIC_setAdrMode(1);
+    resumeConnection();
+    LMIC_setDrTxpow(DR_SF8, 14);
+    joined = true;
+    // LMIC_setAdrMode(1);
+    checkpointSession(&sessionStore);
 #else
-  LMIC_startJoining();
-  joined = false;
+    // the session is checkpointed once joined
+    LMIC_startJoining();
+    joined = false;
 #endif
+  }
 
+  if (isWarmReset()) {
+    clair.restoreState(retainedState.value);
+  }
   clair.setCurrentDatarate(LMIC.datarate);
+  retainState();
 
-  os_setCallback(&clairjob, measureAndSendIfDue);
+  // scheduled rather than runnable, so that sleepUntilNextJob() sees it
+  nextMeasurementTime = os_getTime();
+  timers.schedule(&measurementTimer, nextMeasurementTime, ms2osticks(MEASUREMENT_TOLERANCE_MILLIS));
 }
 
 void loop() {
   os_runloop_once();
+#if CLAIR_DEEP_SLEEP
+  sleepUntilNextJob();
+#endif
 }
 
-static void measureAndSendIfDue(osjob_t* job) {
-  (void) (job); // unused
+#if CLAIR_DEEP_SLEEP
+/*
+ * Puts the MCU into standby until the next scheduled job is due. While LMIC
+ * sends an uplink or joins, it polls the radio between its jobs, so the MCU
+ * stays awake; so it does if a job is due within STANDBY_MIN_MILLIS.
+ */
+static void sleepUntilNextJob() {
+  if (LMIC.opmode & (OP_TXDATA | OP_TXRXPEND | OP_JOINING)) return;
+  if (os_queryTimeCriticalJobs(ms2osticks(STANDBY_MIN_MILLIS))) return;
+
+  bit_t deadlineValid;
+  ostime_t deadline = os_getNextDeadline(&deadlineValid);
+  if (!deadlineValid) return;
+  standby.sleepMillis(osticks2ms(deadline - os_getTime()));
+}
+#endif
+
+static void measureAndSendIfDue(void *context) {
+  (void) (context); // unused
 
   if (errorCode != ErrorCode::NO_ERROR) return;
 
+  // LMIC cannot open a receive window while a job runs, so a measurement must not block one that is due
+  if ((LMIC.opmode & OP_TXRXPEND) && os_queryTimeCriticalJobs(ms2osticks(MEASUREMENT_MAX_MILLIS))) {
+    timers.schedule(&measurementTimer, os_getTime() + ms2osticks(MEASUREMENT_MAX_MILLIS), ms2osticks(MEASUREMENT_TOLERANCE_MILLIS));
+    return;
+  }
+
   int16_t currentCO2Concentration = clair.getCO2Concentration();
+  lastMeasurementTime = os_getTime();
   if (currentCO2Concentration < 0) {
     ERROR(ErrorCode::CLAIR_MEASUREMENT_FAILED);
     return;
@@ -64,22 +170,149 @@ static void measureAndSendIfDue(osjob_t* job) {
 
   display.displayCurrentCO2Concentration(currentCO2Concentration);
 
-  if (joined && clair.isMessageDue()) {
-    uint8_t messageBuffer[CLAIR_MAX_MESSAGE_SIZE];
-    uint8_t messageLength;
-    lmic_tx_error_t error;
+  scheduleSendIfDue();
+  retainState();
 
-    PRINTLN("encoding message");
+  nextMeasurementTime += ms2osticks(1000L * clair.getSecondsUntilNextMeasurement());
+  timers.schedule(&measurementTimer, nextMeasurementTime, ms2osticks(MEASUREMENT_TOLERANCE_MILLIS));
+}
+
+/*
+ * Schedules the transmission of a due alert within a measuring period and of
+ * a due message within a sampling period, after the delay that the
+ * transmission jitter picks. Otherwise, nodes that were powered up together,
+ * or that sample on the same UTC grid, would send in lockstep and keep
+ * colliding. The message tells the age of its last sample, so the delay does
+ * not blur its timestamps.
+ *
+ * The delay is drawn once per due message. Drawn again with each measurement
+ * while the message waits, only the earliest of the draws would take effect,
+ * and the random part of the delay would shrink towards 0.
+ */
+static void scheduleSendIfDue() {
+  bool alertDue = clair.isAlertDue();
+  if (!alertDue && !clair.isMessageDue()) return;
+
+  uint32_t boundMillis = 1000L * (alertDue
+      ? ClairchenConfig::MEASURING_PERIOD_SECS
+      : clair.getTransmissionConfig().samplingPeriodSeconds);
+  // an alert only cuts short a pending send that is further away than its own bound
+  if (timers.isPending(&sendTimer) && scheduledSendTime - os_getTime() < ms2osticks(boundMillis)) return;
+  uint32_t delayMillis = CLAIR_TX_JITTER ? transmissionJitter.delayMillis(boundMillis) : 0;
+  PRINT(F("sending in [ms]: ")); PRINTLN(delayMillis);
+  scheduleSend(os_getTime() + ms2osticks(delayMillis));
+}
 
-    messageLength = clair.encodeMessage(messageBuffer, CLAIR_MAX_MESSAGE_SIZE);
+/*
+ * Sends an alert or a message if one is due and LMIC is not busy with
+ * another uplink. Messages that LMIC does not accept stay queued in Clair and
+ * are sent later, as is the backlog, once the previous uplink is complete.
+ *
+ * A message is only closed when the duty cycle lets LMIC send it right away;
+ * otherwise, its samples would age in LMIC while Clair could still add to it.
+ * If a message is due but the bands are blocked, sending is retried once
+ * they are free.
+ */
+static void sendIfDue() {
+  if (!joined) return;
+  // never replace a frame that LMIC has not sent yet
+  if (LMIC.opmode & (OP_TXDATA | OP_TXRXPEND)) return;
 
-    error = LMIC_setTxData2(1, messageBuffer, messageLength, 0);
-    if (error != 0) {
-      ERROR(ErrorCode::TX_FAILED);
+  uint32_t millisUntilTxPossible = getMillisUntilTxPossible();
+  if (millisUntilTxPossible > 0) {
+    if (clair.isAlertDue() || clair.isMessageDue()) {
+      PRINT(F("duty cycle, sending in [ms]: ")); PRINTLN(millisUntilTxPossible);
+      scheduleSend(os_getTime() + ms2osticks(millisUntilTxPossible));
     }
+    return;
+  }
+
+  if (clair.isWallClockSyncDue() && !networkTimeRequested) {
+    // sent with the next uplink, answered in its receive windows
+    LMIC_requestNetworkTime(onNetworkTime, NULL);
+    networkTimeRequested = true;
   }
 
-  os_setTimedCallback(&clairjob, os_getTime() + ms2osticks(1000L * CLAIR_MEASURING_PERIOD_SECS), measureAndSendIfDue);
+  if (clair.isAlertDue()) {
+    uint8_t messageBuffer[clair.ALERT_MESSAGE_SIZE];
+
+    PRINTLN("encoding alert");
+
+    uint8_t messageLength = clair.encodeAlert(messageBuffer, sizeof(messageBuffer));
+    if (messageLength > 0 && LMIC_setTxData2(1, messageBuffer, messageLength, 0) == 0) {
+      encodedSampleAgeSeconds = clair.getEncodedSampleAgeSeconds();
+      clair.commitMessage();
+    } else {
+      PRINTLN(F("WARNING: alert not accepted for transmission, keeping it due"));
+    }
+  } else if (clair.isMessageDue()) {
+    uint8_t messageBuffer[clair.MAX_MESSAGE_SIZE];
+
+    PRINTLN("encoding message");
+
+    // LMIC encrypts the frame right away, so its age fields are filled in now, just before it goes on air
+    uint16_t secondsSinceMeasurement = osticks2ms(os_getTime() - lastMeasurementTime) / 1000;
+    uint8_t messageLength = clair.encodeMessage(messageBuffer, sizeof(messageBuffer), secondsSinceMeasurement);
+    if (messageLength > 0 && LMIC_setTxData2(1, messageBuffer, messageLength, 0) == 0) {
+      encodedSampleAgeSeconds = clair.getEncodedSampleAgeSeconds();
+      clair.commitMessage();
+    } else {
+      PRINTLN(F("WARNING: message not accepted for transmission, keeping its samples"));
+    }
+  }
+}
+
+static bool isWarmReset() {
+#ifdef ARDUINO_ARCH_SAMD
+  // after a power-on reset, the RAM holds random bits
+  if (PM->RCAUSE.bit.POR) return false;
+#endif
+  return retainedState.isValid();
+}
+
+static void retainState() {
+  clair.saveState(&retainedState.value);
+  retainedState.seal();
+}
+
+/*
+ * Aligns Clair's sampling to UTC, from the GPS time the network tells, so
+ * that all nodes sample at the same instants, and moves the next measurement onto the
+ * whole second.
+ */
+static void onNetworkTime(void *userData, int success) {
+  (void) (userData); // unused
+
+  networkTimeRequested = false;
+  lmic_time_reference_t reference;
+  if (!success || !LMIC_getNetworkTimeReference(&reference)) {
+    PRINTLN(F("WARNING: network did not tell the time"));
+    return;
+  }
+  if (errorCode != ErrorCode::NO_ERROR) return;
+
+  ostime_t measurementTime = nextMeasurementTime - ms2osticks(1000L * clair.getSecondsUntilNextMeasurement());
+  int64_t gpsMillis = static_cast<int64_t>(reference.tNetwork) * 1000 + osticks2ms(measurementTime - reference.tLocal);
+  clair.setWallClockSeconds(gpsMillis / 1000);
+
+  nextMeasurementTime = measurementTime + ms2osticks(1000L * clair.getSecondsUntilNextMeasurement() - gpsMillis % 1000);
+  timers.schedule(&measurementTimer, nextMeasurementTime, ms2osticks(MEASUREMENT_TOLERANCE_MILLIS));
+  retainState();
+}
+
+static void scheduleSend(ostime_t time) {
+  if (timers.isPending(&sendTimer) && time - scheduledSendTime >= 0) return;
+
+  scheduledSendTime = time;
+  timers.schedule(&sendTimer, time, ms2osticks(SEND_TOLERANCE_MILLIS));
+}
+
+static void sendWhenPossible(void *context) {
+  (void) (context); // unused
+
+  if (errorCode != ErrorCode::NO_ERROR) return;
+  sendIfDue();
+  retainState();
 }
 
 void onEvent (ev_t ev) {
@@ -108,6 +341,7 @@ void onEvent (ev_t ev) {
       LMIC_setAdrMode(1);
       clair.setCurrentDatarate(LMIC.datarate);
       joined = true;
+      checkpointSession(&sessionStore);
       break;
     /*
       || This event is defined but not used in the code. No
@@ -138,7 +372,11 @@ void onEvent (ev_t ev) {
       PRINT("  Downlink Sequence Counter: ");
       PRINTLN(LMIC.seqnoDn);
 
+      checkpointSession(&sessionStore);
       clair.setCurrentDatarate(LMIC.datarate);
+      // drain the backlog
+      sendIfDue();
+      retainState();
       break;
     case EV_LOST_TSYNC:
       PRINTLN(F("EV_LOST_TSYNC"));
@@ -168,6 +406,9 @@ void onEvent (ev_t ev) {
       PRINTLN(F("EV_TXSTART"));
       PRINT(F("channel: ")); PRINT(LMIC.txChnl);
       PRINT(F(", datarate: ")); PRINTLN(LMIC.datarate);
+      // how long the newest sample of the message took from the sensor to the air
+      PRINT(F("sample-to-air delay [s]: "));
+      PRINTLN(encodedSampleAgeSeconds + osticks2ms(os_getTime() - lastMeasurementTime) / 1000);
       break;
     case EV_TXCANCELED:
       PRINTLN(F("EV_TXCANCELED"));
@@ -0,0 +1,216 @@
+#include "clairchen_codec.h"
+#include <algorithm>
+
+uint8_t ClairchenCodec::encodeCO2ppmByte(uint16_t co2ppm) {
+  co2ppm = std::min(co2ppm, static_cast<uint16_t>(5100));
+  return (co2ppm + 10) / 20; // apply proper rounding
+}
+
+uint8_t ClairchenCodec::encodeTemperatureByte(int16_t temperatureCentiDegrees) {
+  temperatureCentiDegrees = std::max(temperatureCentiDegrees, static_cast<int16_t>(0));
+  temperatureCentiDegrees = std::min(temperatureCentiDegrees, static_cast<int16_t>(3100));
+  uint8_t quantizedTemperature = ((temperatureCentiDegrees + 50) / 100) & 0x1F; // apply proper rounding
+  return quantizedTemperature;
+}
+
+uint8_t ClairchenCodec::encodeHumidityByte(uint16_t humidityCentiPercent) {
+  humidityCentiPercent = std::max(humidityCentiPercent, static_cast<uint16_t>(1000));
+  humidityCentiPercent = std::min(humidityCentiPercent, static_cast<uint16_t>(8000));
+  uint8_t quantizedHumidity = (humidityCentiPercent + 500) / 1000; // quantize to 10 % steps
+  quantizedHumidity -= 1; // start at 0
+  return quantizedHumidity & 0x7;
+}
+
+void ClairchenCodec::encodeSample(clair_sample_t sample, uint8_t *messageBuffer) {
+  messageBuffer[0] = encodeCO2ppmByte(sample.co2ppm);
+
+  messageBuffer[1] = 0;
+  messageBuffer[1] |= encodeTemperatureByte(sample.temperatureCentiDegrees) << 3; // 5 bits
+  messageBuffer[1] |= encodeHumidityByte(sample.humidityCentiPercent); // 3 bits
+}
+
+clair_sample_t ClairchenCodec::decodeSample(const uint8_t *messageBuffer) {
+  clair_sample_t sample;
+  sample.co2ppm = messageBuffer[0] * 20;
+  sample.temperatureCentiDegrees = (messageBuffer[1] >> 3) * 100;
+  sample.humidityCentiPercent = ((messageBuffer[1] & 0x7) + 1) * 1000;
+  return sample;
+}
+
+// within half a step of the decoded value, as the rounding gives, plus a quarter step of hysteresis
+static bool isWithinHysteresis(int32_t value, int32_t decodedValue, int32_t step) {
+  int32_t difference = value - decodedValue;
+  return 4 * difference < 3 * step && 4 * difference > -3 * step;
+}
+
+bool ClairchenCodec::encodesLike(clair_sample_t sample, const uint8_t *encodedSample) {
+  uint8_t encoded[SAMPLE_SIZE];
+  encodeSample(sample, encoded);
+  if (encoded[0] == encodedSample[0] && encoded[1] == encodedSample[1]) return true;
+
+  // clamped as in encoding, so that readings out of range still encode like the range limits
+  clair_sample_t decoded = decodeSample(encodedSample);
+  return isWithinHysteresis(std::min(sample.co2ppm, static_cast<uint16_t>(5100)), decoded.co2ppm, 20)
+    && isWithinHysteresis(std::min(std::max(sample.temperatureCentiDegrees, static_cast<int16_t>(0)), static_cast<int16_t>(3100)),
+        decoded.temperatureCentiDegrees, 100)
+    && isWithinHysteresis(std::min(std::max(sample.humidityCentiPercent, static_cast<uint16_t>(1000)), static_cast<uint16_t>(8000)),
+        decoded.humidityCentiPercent, 1000);
+}
+
+#define MAX_CO2_DELTA_WIDTH 15
+#define MAX_TEMPERATURE_DELTA_WIDTH 3
+#define MAX_HUMIDITY_DELTA_WIDTH 3
+
+// smallest width of a two's complement number that holds the value, 0 for 0
+static uint8_t deltaWidth(int16_t delta) {
+  if (delta == 0) return 0;
+
+  uint8_t width = 1;
+  while (delta < -(1 << (width - 1)) || delta > (1 << (width - 1)) - 1) {
+    width += 1;
+  }
+  return width;
+}
+
+static void writeBits(uint8_t *buffer, uint16_t *bitPosition, int16_t value, uint8_t width) {
+  for (int8_t bit = width - 1; bit >= 0; bit--) {
+    if (value & (1 << bit)) buffer[*bitPosition / 8] |= 0x80 >> (*bitPosition % 8);
+    *bitPosition += 1;
+  }
+}
+
+// the differences of the quantized CO2, temperature, and humidity of each sample after the first to the preceding one
+typedef int16_t quantized_deltas_t[ClairchenCodec::MAX_NROF_RICE_SAMPLES - 1][3];
+
+static void quantizeDeltas(const clair_sample_t *samples, uint8_t numberOfSamples, quantized_deltas_t deltas) {
+  uint8_t previous[3] = {
+    ClairchenCodec::encodeCO2ppmByte(samples[0].co2ppm),
+    ClairchenCodec::encodeTemperatureByte(samples[0].temperatureCentiDegrees),
+    ClairchenCodec::encodeHumidityByte(samples[0].humidityCentiPercent)
+  };
+  for (uint8_t i = 1; i < numberOfSamples; i++) {
+    uint8_t current[3] = {
+      ClairchenCodec::encodeCO2ppmByte(samples[i].co2ppm),
+      ClairchenCodec::encodeTemperatureByte(samples[i].temperatureCentiDegrees),
+      ClairchenCodec::encodeHumidityByte(samples[i].humidityCentiPercent)
+    };
+    for (uint8_t j = 0; j < 3; j++) {
+      deltas[i - 1][j] = current[j] - previous[j];
+      previous[j] = current[j];
+    }
+  }
+}
+
+uint8_t ClairchenCodec::encodeDeltaSamples(const clair_sample_t *samples, uint8_t numberOfSamples,
+    uint8_t *messageBuffer, uint16_t messageBufferSize) {
+  if (numberOfSamples == 0 || numberOfSamples > MAX_NROF_RICE_SAMPLES) return 0;
+
+  quantized_deltas_t deltas;
+  quantizeDeltas(samples, numberOfSamples, deltas);
+  uint8_t widths[3] = { 0, 0, 0 };
+  for (uint8_t i = 0; i < numberOfSamples - 1; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      widths[j] = std::max(widths[j], deltaWidth(deltas[i][j]));
+    }
+  }
+
+  if (widths[0] > MAX_CO2_DELTA_WIDTH
+      || widths[1] > MAX_TEMPERATURE_DELTA_WIDTH
+      || widths[2] > MAX_HUMIDITY_DELTA_WIDTH) return 0;
+
+  uint16_t length = compressedSamplesSize(numberOfSamples, widths[0] + widths[1] + widths[2]);
+  if (length > messageBufferSize) return 0;
+
+  encodeSample(samples[0], messageBuffer);
+  messageBuffer[SAMPLE_SIZE] = widths[0] << 4 | widths[1] << 2 | widths[2];
+
+  uint8_t *deltaBuffer = messageBuffer + SAMPLE_SIZE + 1;
+  for (uint16_t i = 0; i < length - SAMPLE_SIZE - 1; i++) {
+    deltaBuffer[i] = 0;
+  }
+
+  uint16_t bitPosition = 0;
+  for (uint8_t i = 0; i < numberOfSamples - 1; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      writeBits(deltaBuffer, &bitPosition, deltas[i][j], widths[j]);
+    }
+  }
+
+  return length;
+}
+
+#define MAX_CO2_RICE_PARAMETER 7
+#define MAX_TEMPERATURE_RICE_PARAMETER 3
+#define MAX_HUMIDITY_RICE_PARAMETER 3
+
+static uint16_t zigzag(int16_t delta) {
+  return delta >= 0 ? 2 * delta : -2 * delta - 1;
+}
+
+static uint16_t riceCodeLength(uint16_t value, uint8_t parameter) {
+  return (value >> parameter) + 1 + parameter;
+}
+
+static void writeRiceCode(uint8_t *buffer, uint16_t *bitPosition, uint16_t value, uint8_t parameter) {
+  for (uint16_t i = 0; i < (value >> parameter); i++) {
+    writeBits(buffer, bitPosition, 1, 1);
+  }
+  writeBits(buffer, bitPosition, 0, 1);
+  writeBits(buffer, bitPosition, value, parameter);
+}
+
+uint8_t ClairchenCodec::encodeRiceSamples(const clair_sample_t *samples, uint8_t numberOfSamples,
+    uint8_t *messageBuffer, uint16_t messageBufferSize, uint8_t *messageHeader) {
+  if (numberOfSamples == 0 || numberOfSamples > MAX_NROF_RICE_SAMPLES) return 0;
+
+  const uint8_t maxParameters[3] = {
+    MAX_CO2_RICE_PARAMETER, MAX_TEMPERATURE_RICE_PARAMETER, MAX_HUMIDITY_RICE_PARAMETER
+  };
+
+  // zigzag-mapped once, for the parameter search and the codes
+  quantized_deltas_t deltas;
+  quantizeDeltas(samples, numberOfSamples, deltas);
+  uint16_t values[MAX_NROF_RICE_SAMPLES - 1][3];
+  for (uint8_t i = 0; i < numberOfSamples - 1; i++) {
+    for (uint8_t j = 0; j < 3; j++) values[i][j] = zigzag(deltas[i][j]);
+  }
+
+  // pick the parameter with the shortest codes for each quantity
+  uint8_t parameters[3];
+  uint16_t bits = 0;
+  for (uint8_t j = 0; j < 3; j++) {
+    uint16_t shortestLength = UINT16_MAX;
+    for (uint8_t parameter = 0; parameter <= maxParameters[j]; parameter++) {
+      uint16_t length = 0;
+      for (uint8_t i = 0; i < numberOfSamples - 1; i++) {
+        length += riceCodeLength(values[i][j], parameter);
+      }
+      if (length < shortestLength) {
+        shortestLength = length;
+        parameters[j] = parameter;
+      }
+    }
+    bits += shortestLength;
+  }
+
+  uint16_t length = SAMPLE_SIZE + 1 + (bits + 7) / 8;
+  if (length > messageBufferSize) return 0;
+
+  encodeSample(samples[0], messageBuffer);
+  messageBuffer[SAMPLE_SIZE] = (numberOfSamples - 1) << 4 | parameters[1] << 2 | parameters[2];
+  *messageHeader = parameters[0];
+
+  uint8_t *codeBuffer = messageBuffer + SAMPLE_SIZE + 1;
+  for (uint16_t i = 0; i < length - SAMPLE_SIZE - 1; i++) {
+    codeBuffer[i] = 0;
+  }
+
+  uint16_t bitPosition = 0;
+  for (uint8_t i = 0; i < numberOfSamples - 1; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      writeRiceCode(codeBuffer, &bitPosition, values[i][j], parameters[j]);
+    }
+  }
+
+  return length;
+}
@@ -0,0 +1,86 @@
+#ifndef CLAIRCHEN_CODEC_H
+#define CLAIRCHEN_CODEC_H
+
+#include <stdint.h>
+#include "sensor.h"
+
+/**
+ * Sample encoding of the Clairchen node
+ *
+ * Each sample takes two bytes: the CO2 concentration in steps of 20 ppm,
+ * followed by the temperature in °C (5 bits) and the relative humidity in
+ * steps of 10 % (3 bits).
+ *
+ * In delta encoding, the first sample is encoded as above, followed by a
+ * byte with the bit widths of the CO2 (bits 4-7), temperature (bits 2-3), and
+ * humidity (bits 0-1) deltas. Then, for each further sample, the differences
+ * of its quantized values to those of the preceding sample follow as two's
+ * complement numbers of these widths, packed MSB first.
+ *
+ * In Rice encoding, the first sample is encoded as above, followed by a byte
+ * with the number of samples - 1 (bits 4-7) and the Rice parameters of the
+ * temperature (bits 2-3) and humidity (bits 0-1) deltas. The Rice parameter
+ * of the CO2 deltas goes into the message-specific header. Then, for each
+ * further sample, the zigzag-mapped (0, -1, 1, -2, ... to 0, 1, 2, 3, ...)
+ * CO2, temperature, and humidity deltas follow as Rice codes: the value
+ * shifted right by the parameter in unary (ones terminated by a zero),
+ * followed by the parameter's number of low bits, packed MSB first.
+ */
+class ClairchenCodec {
+  public:
+    static const uint8_t SAMPLE_SIZE = 2;
+
+    static uint8_t encodeCO2ppmByte(uint16_t co2ppm);
+
+    static uint8_t encodeTemperatureByte(int16_t temperatureCentiDegrees);
+
+    static uint8_t encodeHumidityByte(uint16_t humidityCentiPercent);
+
+    /**
+     * Writes SAMPLE_SIZE bytes to messageBuffer.
+     */
+    static void encodeSample(clair_sample_t sample, uint8_t *messageBuffer);
+
+    /**
+     * Reads SAMPLE_SIZE bytes written by encodeSample(). The values are
+     * quantized, so that encoding the sample again yields the same bytes.
+     */
+    static clair_sample_t decodeSample(const uint8_t *messageBuffer);
+
+    /**
+     * Returns whether the sample encodes like the one written by
+     * encodeSample() to encodedSample, or only differs because its readings
+     * lie within a quarter step beyond a rounding boundary, e.g., because they
+     * dither across it. The values decoded from encodedSample are then off by
+     * less than a step from those of the sample.
+     */
+    static bool encodesLike(clair_sample_t sample, const uint8_t *encodedSample);
+
+    static const uint8_t MAX_NROF_RICE_SAMPLES = 16;
+
+    /**
+     * Size of delta- or Rice-encoded samples with the given number of bits
+     * per sample after the first
+     */
+    static constexpr uint16_t compressedSamplesSize(uint8_t numberOfSamples, uint8_t bitsPerDelta) {
+      return SAMPLE_SIZE + 1 + ((numberOfSamples - 1) * bitsPerDelta + 7) / 8;
+    }
+
+    /**
+     * Returns the number of bytes written to messageBuffer, or 0 if a delta
+     * exceeds the widths the format can express, if there are more than
+     * MAX_NROF_RICE_SAMPLES, or if the buffer is too small.
+     */
+    static uint8_t encodeDeltaSamples(const clair_sample_t *samples, uint8_t numberOfSamples,
+        uint8_t *messageBuffer, uint16_t messageBufferSize);
+
+    /**
+     * Returns the number of bytes written to messageBuffer, or 0 if there are
+     * more than MAX_NROF_RICE_SAMPLES or the buffer is too small.
+     * The 3-bit message-specific header is returned in messageHeader.
+     */
+    static uint8_t encodeRiceSamples(const clair_sample_t *samples, uint8_t numberOfSamples,
+        uint8_t *messageBuffer, uint16_t messageBufferSize, uint8_t *messageHeader);
+};
+
+#endif /* CLAIRCHEN_CODEC_H */
@@ -0,0 +1,47 @@
+#ifndef CLAIRCHEN_CONFIG_H
+#define CLAIRCHEN_CONFIG_H
+
+#include <stdint.h>
+#include "clair.h"
+#include "clairchen_codec.h"
+
+/**
+ * Compile-time parameters of the Clairchen node for Clair<SensorT, Config>
+ */
+struct ClairchenConfig {
+  typedef ClairchenCodec Codec;
+
+  /* the SCD30 measures every 2 s; it reports its first measurement one interval after waking up */
+  static constexpr uint16_t MEASURING_PERIOD_SECS = 5;
+  static constexpr uint16_t SENSOR_WARMUP_SECS = 5;
+  static constexpr uint8_t MEASUREMENTS_PER_SAMPLE = 12;
+  static constexpr bool WINDOWED_SAMPLING = CLAIR_WINDOWED_SAMPLING;
+  static constexpr uint16_t SWINGING_DOOR_DEVIATION_PPM = CLAIR_SWINGING_DOOR_DEVIATION_PPM;
+
+  /* more than 8 samples require Rice encoding */
+  static constexpr uint8_t MAX_NROF_SAMPLES_PER_MESSAGE = ClairchenCodec::MAX_NROF_RICE_SAMPLES;
+  /* a backlog of four full messages, about 15 hours at the longest sampling period */
+  static constexpr uint8_t SAMPLE_QUEUE_CAPACITY = 4 * MAX_NROF_SAMPLES_PER_MESSAGE;
+
+  /* sampling periods are multiples of this unit so that they fit into one byte */
+  static constexpr uint16_t SAMPLING_PERIOD_UNIT_SECS = CLAIR_SAMPLING_PERIOD_UNIT_SECS;
+  static constexpr uint16_t MIN_SAMPLING_PERIOD_SECS = 60;
+  static constexpr uint16_t MAX_SAMPLING_PERIOD_SECS = 14 * 60;
+
+  /* the wall-clock time is requested from the network again after this long, to make up for clock drift */
+  static constexpr uint32_t WALL_CLOCK_SYNC_INTERVAL_SECS = 24 * 60 * 60;
+
+  /* GPS time runs ahead of UTC by the leap seconds since 1980, 18 s since 2017; samples end on the UTC grid */
+  static constexpr uint32_t GPS_UTC_OFFSET_SECS = 18;
+
+  /* unchanged samples are not sent, but a heartbeat at least this often */
+  static constexpr uint16_t HEARTBEAT_INTERVAL_SECS = 3 * 60 * 60;
+
+  /* a window opening drops the concentration by more than 100 ppm per minute */
+  static constexpr uint16_t ALERT_TREND_PPM_PER_MINUTE = 50;
+  static constexpr uint16_t ALERT_TREND_WINDOW_SECS = 60;
+  static constexpr uint16_t AIR_QUALITY_HYSTERESIS_PPM = 30;
+  static constexpr uint16_t MIN_ALERT_INTERVAL_SECS = 15 * 60;
+};
+
+#endif /* CLAIRCHEN_CONFIG_H */
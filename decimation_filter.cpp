@@ -0,0 +1,34 @@
+#include "decimation_filter.h"
+
+DecimationFilter::DecimationFilter() {
+  reset();
+}
+
+void DecimationFilter::add(clair_sample_t measurement) {
+  sumOfCo2ppms += measurement.co2ppm;
+  sumOfTemperatures += measurement.temperatureCentiDegrees;
+  sumOfHumidities += measurement.humidityCentiPercent;
+  numberOfMeasurements += 1;
+}
+
+uint16_t DecimationFilter::count() {
+  return numberOfMeasurements;
+}
+
+clair_sample_t DecimationFilter::average() {
+  clair_sample_t averageSample;
+  averageSample.co2ppm = (sumOfCo2ppms + (numberOfMeasurements / 2)) / numberOfMeasurements;
+  int32_t halfOfMeasurements = numberOfMeasurements / 2;
+  averageSample.temperatureCentiDegrees = (sumOfTemperatures
+      + (sumOfTemperatures < 0 ? -halfOfMeasurements : halfOfMeasurements)) / numberOfMeasurements;
+  averageSample.humidityCentiPercent = (sumOfHumidities + (numberOfMeasurements / 2)) / numberOfMeasurements;
+
+  return averageSample;
+}
+
+void DecimationFilter::reset() {
+  sumOfCo2ppms = 0;
+  sumOfTemperatures = 0;
+  sumOfHumidities = 0;
+  numberOfMeasurements = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef DECIMATION_FILTER_H
+#define DECIMATION_FILTER_H
+
+#include <stdint.h>
+#include "sensor.h"
+
+/**
+ * Averages all measurements taken within a sampling period.
+ *
+ * The filter keeps running sums only, so memory and work per measurement
+ * stay constant regardless of the length of the sampling period.
+ */
+class DecimationFilter {
+  public:
+    /**
+     * Constructor
+     */
+    DecimationFilter();
+
+    /**
+     * Add a measurement to the running average.
+     */
+    void add(clair_sample_t measurement);
+
+    /**
+     * Number of measurements added since the last reset
+     */
+    uint16_t count();
+
+    /**
+     * Average of all measurements added since the last reset
+     *
+     * Must not be called if no measurement has been added.
+     */
+    clair_sample_t average();
+
+    /**
+     * Start a new sampling period.
+     */
+    void reset();
+
+  private:
+    uint32_t sumOfCo2ppms;
+    int32_t sumOfTemperatures;
+    uint32_t sumOfHumidities;
+    uint16_t numberOfMeasurements;
+};
+
+#endif /* DECIMATION_FILTER_H */
@@ -18,7 +18,7 @@ class Display {
     virtual void displayCurrentCO2Concentration(uint16_t co2Concentration) = 0;
     virtual void displayError(ErrorCode errorCode) = 0;
 
-    inline CO2AirQuality concentrationToAirQuality(uint16_t co2Concentration) {
+    static inline CO2AirQuality concentrationToAirQuality(uint16_t co2Concentration) {
       if (co2Concentration < DISPLAY_THRESHOLD_GOOD) return CO2AirQuality::veryGood;
       if (co2Concentration < DISPLAY_THRESHOLD_FAIR) return CO2AirQuality::good;
       if (co2Concentration < DISPLAY_THRESHOLD_BAD) return CO2AirQuality::fair;
@@ -0,0 +1,73 @@
+#ifdef ARDUINO_ARCH_SAMD
+
+#include "flash_log_storage.h"
+#include <Arduino.h>
+#include <string.h>
+
+/*
+ * Zero-initialized constants are placed in flash. The area is erased before
+ * its first use, so its initial contents do not matter.
+ */
+__attribute__((aligned(FLASH_LOG_STORAGE_ROW_SIZE)))
+static const uint8_t logArea[FLASH_LOG_STORAGE_SIZE] = { };
+
+static void executeCommand(uint32_t command) {
+  NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | command;
+  while (!NVMCTRL->INTFLAG.bit.READY) {}
+}
+
+FlashLogStorage::FlashLogStorage(uint16_t firstRow, uint16_t numberOfRows) {
+  offset = static_cast<uint32_t>(firstRow) * FLASH_LOG_STORAGE_ROW_SIZE;
+  size = static_cast<uint32_t>(numberOfRows) * FLASH_LOG_STORAGE_ROW_SIZE;
+  if (offset + size > FLASH_LOG_STORAGE_SIZE) size = 0;
+}
+
+uint16_t FlashLogStorage::blockSize() {
+  return FLASH_LOG_STORAGE_ROW_SIZE;
+}
+
+uint16_t FlashLogStorage::numberOfBlocks() {
+  return size / FLASH_LOG_STORAGE_ROW_SIZE;
+}
+
+bool FlashLogStorage::read(uint32_t address, uint8_t *data, uint16_t length) {
+  if (address + length > size) return false;
+
+  // the compiler must not assume that the constants are still zero
+  const volatile uint8_t *source = logArea + offset + address;
+  for (uint16_t i = 0; i < length; i++) data[i] = source[i];
+  return true;
+}
+
+bool FlashLogStorage::write(uint32_t address, const uint8_t *data, uint16_t length) {
+  if (address + length > size || address % 4 != 0 || length % 4 != 0) return false;
+
+  // write page by page; words left untouched in the page buffer stay 0xFF and leave the flash as it is
+  NVMCTRL->CTRLB.bit.MANW = 1;
+  volatile uint32_t *destination = (volatile uint32_t *) (logArea + offset + address);
+  while (length > 0) {
+    executeCommand(NVMCTRL_CTRLA_CMD_PBC);
+    do {
+      uint32_t word;
+      memcpy(&word, data, 4);
+      *destination++ = word;
+      data += 4;
+      length -= 4;
+    } while (length > 0 && (uint32_t) destination % FLASH_LOG_STORAGE_PAGE_SIZE != 0);
+    executeCommand(NVMCTRL_CTRLA_CMD_WP);
+  }
+
+  return NVMCTRL->INTFLAG.bit.ERROR == 0;
+}
+
+bool FlashLogStorage::erase(uint16_t block) {
+  if (block >= numberOfBlocks()) return false;
+
+  // the NVM controller takes 16-bit word addresses
+  NVMCTRL->ADDR.reg = (uint32_t) (logArea + offset + block * FLASH_LOG_STORAGE_ROW_SIZE) / 2;
+  executeCommand(NVMCTRL_CTRLA_CMD_ER);
+
+  return NVMCTRL->INTFLAG.bit.ERROR == 0;
+}
+
+#endif /* ARDUINO_ARCH_SAMD */
@@ -0,0 +1,35 @@
+#ifndef FLASH_LOG_STORAGE_H
+#define FLASH_LOG_STORAGE_H
+
+#include "log_storage.h"
+
+/* the SAMD21 erases its flash in rows of 4 pages of 64 bytes */
+#define FLASH_LOG_STORAGE_ROW_SIZE 256
+#define FLASH_LOG_STORAGE_PAGE_SIZE 64
+#define FLASH_LOG_STORAGE_SIZE (32 * 1024)
+
+/**
+ * LogStorage in a reserved area of the SAMD21's internal flash
+ *
+ * The area is part of the sketch image, so uploading a sketch erases it.
+ * Each instance uses a range of its rows.
+ */
+class FlashLogStorage final : public LogStorage {
+  public:
+    /**
+     * Constructor
+     */
+    FlashLogStorage(uint16_t firstRow, uint16_t numberOfRows);
+
+    uint16_t blockSize() override;
+    uint16_t numberOfBlocks() override;
+    bool read(uint32_t address, uint8_t *data, uint16_t length) override;
+    bool write(uint32_t address, const uint8_t *data, uint16_t length) override;
+    bool erase(uint16_t block) override;
+
+  private:
+    uint32_t offset;
+    uint32_t size;
+};
+
+#endif /* FLASH_LOG_STORAGE_H */
@@ -0,0 +1,84 @@
+#include "hardware_blinking_display.h"
+
+// how long the LED stays on, and then off
+#define PERIOD_GOOD 1000
+#define PERIOD_FAIR 500
+#define PERIOD_BAD 250
+#define PERIOD_ERROR 125
+#define PERIOD_ERROR_SILENCE 1000
+
+#define MILLIS_TO_TICKS(MS) (static_cast<uint32_t>(MS) * LED_TIMER_TICKS_PER_SEC / 1000)
+
+// a blink of the error code per cycle, then dark cycles for the silence
+#define ERROR_SILENCE_CYCLES (PERIOD_ERROR_SILENCE / (2 * PERIOD_ERROR))
+#define MAX_ERROR_BLINKS (LED_TIMER_MAX_PATTERN - ERROR_SILENCE_CYCLES)
+
+HardwareBlinkingDisplay::HardwareBlinkingDisplay(LedTimer *ledTimerArg) {
+  ledTimer = ledTimerArg;
+  currentPeriod = PERIOD_GOOD;
+  errorCodeNumber = static_cast<int>(ErrorCode::NO_ERROR);
+}
+
+bool HardwareBlinkingDisplay::errorHasOccurred() {
+  return errorCodeNumber != static_cast<int>(ErrorCode::NO_ERROR);
+}
+
+void HardwareBlinkingDisplay::blink(uint16_t period) {
+  led_pattern_t pattern;
+  pattern.period = MILLIS_TO_TICKS(2 * period) - 1;
+  pattern.length = 1;
+  pattern.compare[0] = MILLIS_TO_TICKS(period);
+  ledTimer->play(pattern);
+}
+
+void HardwareBlinkingDisplay::setup() {
+  ledTimer->begin();
+  currentPeriod = PERIOD_GOOD;
+  errorCodeNumber = static_cast<int>(ErrorCode::NO_ERROR);
+  blink(currentPeriod);
+}
+
+void HardwareBlinkingDisplay::displayCurrentCO2Concentration(uint16_t co2Concentration) {
+  DebugDisplay::displayCurrentCO2Concentration(co2Concentration);
+
+  if (errorHasOccurred()) return;
+
+  uint16_t period;
+  switch (concentrationToAirQuality(co2Concentration)) {
+    case CO2AirQuality::veryGood:
+    case CO2AirQuality::good:
+      period = PERIOD_GOOD;
+      break;
+    case CO2AirQuality::fair:
+      period = PERIOD_FAIR;
+      break;
+    default:
+      period = PERIOD_BAD;
+  }
+
+  // the timer keeps blinking as long as the air quality stays the same
+  if (period == currentPeriod) return;
+  currentPeriod = period;
+  blink(currentPeriod);
+}
+
+void HardwareBlinkingDisplay::displayError(ErrorCode errorCode) {
+  DebugDisplay::displayError(errorCode);
+
+  int number = static_cast<int>(errorCode);
+  if (number == errorCodeNumber) return;
+  errorCodeNumber = number;
+  if (!errorHasOccurred()) {
+    blink(currentPeriod);
+    return;
+  }
+
+  int blinks = number < MAX_ERROR_BLINKS ? number : MAX_ERROR_BLINKS;
+  led_pattern_t pattern;
+  pattern.period = MILLIS_TO_TICKS(2 * PERIOD_ERROR) - 1;
+  pattern.length = blinks + ERROR_SILENCE_CYCLES;
+  for (int i = 0; i < pattern.length; i++) {
+    pattern.compare[i] = i < blinks ? MILLIS_TO_TICKS(PERIOD_ERROR) : 0;
+  }
+  ledTimer->play(pattern);
+}
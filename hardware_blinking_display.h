@@ -0,0 +1,32 @@
+#ifndef HARDWARE_BLINKING_DISPLAY_H
+#define HARDWARE_BLINKING_DISPLAY_H
+
+#include "debug_display.h"
+#include "led_timer.h"
+#include <stdint.h>
+
+/**
+ * Blinks LED_BUILTIN like BlinkingDisplay, but off a hardware timer, so
+ * that the CPU only has to act when the air quality or the error changes.
+ */
+class HardwareBlinkingDisplay: public DebugDisplay {
+  public:
+    /**
+     * Constructor
+     */
+    HardwareBlinkingDisplay(LedTimer *ledTimer);
+
+    void setup() override;
+    void displayCurrentCO2Concentration(uint16_t co2Concentration) override;
+    void displayError(ErrorCode errorCode) override;
+
+  private:
+    LedTimer *ledTimer;
+    uint16_t currentPeriod;
+    int errorCodeNumber;
+
+    bool errorHasOccurred();
+    void blink(uint16_t period);
+};
+
+#endif /* HARDWARE_BLINKING_DISPLAY_H */
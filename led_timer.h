@@ -0,0 +1,37 @@
+#ifndef LED_TIMER_H
+#define LED_TIMER_H
+
+#include <stdint.h>
+
+/* the counter runs off the 32.768 kHz crystal, divided by 32 */
+#define LED_TIMER_TICKS_PER_SEC 1024
+#define LED_TIMER_MAX_PATTERN 16
+
+/**
+ * Register values of a blink pattern
+ *
+ * In each cycle, the counter runs from 0 to period, and the LED is on while
+ * it is below the cycle's compare value. The compare values of the cycles
+ * repeat after length cycles.
+ */
+typedef struct {
+  uint16_t period;
+  uint8_t length;
+  uint16_t compare[LED_TIMER_MAX_PATTERN];
+} led_pattern_t;
+
+/**
+ * A timer whose waveform output drives LED_BUILTIN, so that the LED blinks
+ * on its own while the CPU sleeps
+ */
+class LedTimer {
+  public:
+    virtual void begin() = 0;
+
+    /**
+     * Play the pattern over and over, starting with its first cycle.
+     */
+    virtual void play(const led_pattern_t &pattern) = 0;
+};
+
+#endif /* LED_TIMER_H */
@@ -0,0 +1,40 @@
+#ifndef LOG_STORAGE_H
+#define LOG_STORAGE_H
+
+#include <stdint.h>
+
+/**
+ * Non-volatile memory that behaves like NOR flash
+ *
+ * The memory consists of blocks that can only be erased as a whole, which
+ * sets all their bytes to 0xFF. Writes may only clear bits of erased bytes.
+ * Addresses count from the start of the first block.
+ */
+class LogStorage {
+  public:
+    /**
+     * Size of an erase block in bytes
+     */
+    virtual uint16_t blockSize() = 0;
+
+    virtual uint16_t numberOfBlocks() = 0;
+
+    /**
+     * Returns false if the read failed.
+     */
+    virtual bool read(uint32_t address, uint8_t *data, uint16_t size) = 0;
+
+    /**
+     * Write to erased memory. Address and size are multiples of 4.
+     *
+     * Returns false if the write failed.
+     */
+    virtual bool write(uint32_t address, const uint8_t *data, uint16_t size) = 0;
+
+    /**
+     * Returns false if the erase failed.
+     */
+    virtual bool erase(uint16_t block) = 0;
+};
+
+#endif /* LOG_STORAGE_H */
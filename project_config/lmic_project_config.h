@@ -7,4 +7,8 @@
 //#define CFG_kr920 1
 //#define CFG_in866 1
 #define CFG_sx1276_radio 1
-//#define LMIC_USE_INTERRUPTS
+// DeviceTimeReq, to align sampling to UTC
+#define LMIC_ENABLE_DeviceTimeReq 1
+// the DIO lines of the radio raise interrupts, whose handlers stamp the time of the edge;
+// on the Feather M0, DIO1 has to be wired to pin 6
+#define LMIC_USE_INTERRUPTS 1
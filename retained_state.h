@@ -0,0 +1,67 @@
+#ifndef RETAINED_STATE_H
+#define RETAINED_STATE_H
+
+#include <stdint.h>
+#include "checksum.h"
+
+/*
+ * Declares a variable that the start-up code leaves alone, so that it keeps
+ * its contents across a warm reset. The SAMD core's linker script places the
+ * .noinit section behind .bss, which is the only RAM the start-up code clears.
+ */
+#ifdef ARDUINO_ARCH_SAMD
+#define RETAINED_STATE_NOINIT __attribute__((section(".noinit")))
+#else
+#define RETAINED_STATE_NOINIT
+#endif
+
+#define RETAINED_STATE_MAGIC 0xC1A1C0DE
+
+/**
+ * State in RAM that survives a warm reset, e.g., by the watchdog or a
+ * brownout, with a checksum that tells whether it is valid
+ *
+ * After a power-on reset, the RAM holds random bits, which are very unlikely
+ * to pass the check. The checksum covers the build time, so that the state of
+ * another sketch, e.g., the one before an upload, is not taken for valid.
+ *
+ * Declare instances with RETAINED_STATE_NOINIT, and call seal() after each
+ * update of the value. The constructor leaves the value alone, it is only
+ * meaningful after seal() or if isValid().
+ */
+template <typename T>
+class RetainedState {
+  public:
+    RetainedState() {}
+
+    union {
+      T value;
+    };
+
+    void seal() {
+      magic = RETAINED_STATE_MAGIC;
+      checksum = computeChecksum();
+    }
+
+    bool isValid() {
+      return magic == RETAINED_STATE_MAGIC && checksum == computeChecksum();
+    }
+
+    void invalidate() {
+      magic = 0;
+    }
+
+  private:
+    uint32_t magic;
+    uint16_t checksum;
+
+    uint16_t computeChecksum() {
+      static const char buildTime[] = __DATE__ " " __TIME__;
+      uint16_t size = sizeof(T);
+      uint16_t sum = fletcher16(reinterpret_cast<const uint8_t *>(buildTime), sizeof(buildTime));
+      sum = fletcher16(reinterpret_cast<const uint8_t *>(&size), sizeof(size), sum);
+      return fletcher16(reinterpret_cast<const uint8_t *>(&value), sizeof(T), sum);
+    }
+};
+
+#endif /* RETAINED_STATE_H */
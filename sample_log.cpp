@@ -0,0 +1,120 @@
+#include "sample_log.h"
+
+/* erased storage reads as all ones, so this sequence number marks free slots */
+#define FREE_SEQUENCE_NUMBER 0xFFFF
+
+SampleLog::SampleLog(LogStorage *storageArg) {
+  storage = storageArg;
+  ready = false;
+
+  recordsPerBlock = 0;
+  numberOfSlots = 0;
+  head = 0;
+  numberOfRecords = 0;
+  numberOfOldRecords = 0;
+  nextSequenceNumber = 0;
+}
+
+static uint16_t nextAfter(uint16_t sequenceNumber) {
+  sequenceNumber += 1;
+  return sequenceNumber == FREE_SEQUENCE_NUMBER ? 0 : sequenceNumber;
+}
+
+bool SampleLog::readSlot(uint16_t slot, sample_log_record_t *record) {
+  uint8_t bytes[SAMPLE_LOG_RECORD_SIZE];
+  if (!storage->read(static_cast<uint32_t>(slot) * SAMPLE_LOG_RECORD_SIZE, bytes, sizeof(bytes))) return false;
+
+  record->sequenceNumber = bytes[0] | bytes[1] << 8;
+  record->time = bytes[2] | bytes[3] << 8 | static_cast<uint32_t>(bytes[4]) << 16 | static_cast<uint32_t>(bytes[5]) << 24;
+  for (uint8_t i = 0; i < SAMPLE_LOG_SAMPLE_SIZE; i++) record->sample[i] = bytes[6 + i];
+  return true;
+}
+
+bool SampleLog::begin() {
+  recordsPerBlock = storage->blockSize() / SAMPLE_LOG_RECORD_SIZE;
+  uint32_t slots = static_cast<uint32_t>(recordsPerBlock) * storage->numberOfBlocks();
+  // sequence numbers must tell the order of all records apart, and one block is always being reused
+  if (recordsPerBlock == 0 || storage->numberOfBlocks() < 2 || slots >= 0x8000) return false;
+  numberOfSlots = slots;
+
+  // the newest record is the one furthest ahead of any other
+  bool found = false;
+  uint16_t newestSlot = 0;
+  uint16_t newestSequenceNumber = 0;
+  numberOfOldRecords = 0;
+  for (uint16_t slot = 0; slot < numberOfSlots; slot++) {
+    sample_log_record_t record;
+    if (!readSlot(slot, &record)) return false;
+    if (record.sequenceNumber == FREE_SEQUENCE_NUMBER) continue;
+
+    // slots are used in order and freed a block at a time, so the used ones are the newest records
+    numberOfOldRecords += 1;
+
+    if (!found || static_cast<int16_t>(record.sequenceNumber - newestSequenceNumber) > 0) {
+      newestSlot = slot;
+      newestSequenceNumber = record.sequenceNumber;
+      found = true;
+    }
+  }
+
+  head = found ? (newestSlot + 1) % numberOfSlots : 0;
+  nextSequenceNumber = found ? nextAfter(newestSequenceNumber) : 0;
+  numberOfRecords = 0;
+  ready = true;
+  return true;
+}
+
+void SampleLog::keepNewest(uint16_t count) {
+  if (!ready) return;
+  numberOfRecords = count < numberOfOldRecords ? count : numberOfOldRecords;
+}
+
+bool SampleLog::append(uint32_t time, const uint8_t *sample) {
+  if (!ready) return false;
+
+  if (head % recordsPerBlock == 0) {
+    // the block to erase holds the oldest records if the log is full
+    uint16_t maxRecordsBefore = numberOfSlots - recordsPerBlock;
+    if (numberOfRecords > maxRecordsBefore) numberOfRecords = maxRecordsBefore;
+    if (!storage->erase(head / recordsPerBlock)) {
+      ready = false;
+      return false;
+    }
+  }
+
+  uint8_t bytes[SAMPLE_LOG_RECORD_SIZE];
+  bytes[0] = nextSequenceNumber;
+  bytes[1] = nextSequenceNumber >> 8;
+  for (uint8_t i = 0; i < 4; i++) bytes[2 + i] = time >> (8 * i);
+  for (uint8_t i = 0; i < SAMPLE_LOG_SAMPLE_SIZE; i++) bytes[6 + i] = sample[i];
+
+  if (!storage->write(static_cast<uint32_t>(head) * SAMPLE_LOG_RECORD_SIZE, bytes, sizeof(bytes))) {
+    ready = false;
+    return false;
+  }
+
+  head = (head + 1) % numberOfSlots;
+  nextSequenceNumber = nextAfter(nextSequenceNumber);
+  numberOfRecords += 1;
+  return true;
+}
+
+uint16_t SampleLog::size() {
+  return numberOfRecords;
+}
+
+uint16_t SampleLog::capacity() {
+  return numberOfSlots - recordsPerBlock;
+}
+
+bool SampleLog::read(uint16_t position, sample_log_record_t *record) {
+  if (!ready || position >= numberOfRecords) return false;
+
+  uint16_t slot = (head + numberOfSlots - numberOfRecords + position) % numberOfSlots;
+  return readSlot(slot, record);
+}
+
+void SampleLog::discardOldest(uint16_t count) {
+  if (count > numberOfRecords) count = numberOfRecords;
+  numberOfRecords -= count;
+}
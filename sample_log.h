@@ -0,0 +1,97 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <stdint.h>
+#include "log_storage.h"
+
+/* an encoded sample, as sent in messages */
+#define SAMPLE_LOG_SAMPLE_SIZE 2
+/* sequence number (2 bytes), time (4 bytes), and sample, little endian */
+#define SAMPLE_LOG_RECORD_SIZE 8
+
+typedef struct {
+  uint16_t sequenceNumber;
+  uint32_t time; // seconds of the caller's clock, e.g., Clair's, which a warm reset does not reset
+  uint8_t sample[SAMPLE_LOG_SAMPLE_SIZE];
+} sample_log_record_t;
+
+/**
+ * Append-only log of encoded samples in non-volatile memory
+ *
+ * Records are written one after the other through the storage, wrapping
+ * around at its end. Each block is erased right before the first record is
+ * written to it, which drops the oldest records once the log is full, so all
+ * blocks wear evenly. Consecutive sequence numbers let begin() find the end
+ * of the log after a reset.
+ *
+ * The log keeps track of the records that have not been read and discarded
+ * yet, oldest first. Records written before a reset are only among them once
+ * keepNewest() takes them over, since only the caller can tell whether their
+ * times still apply.
+ */
+class SampleLog {
+  public:
+    /**
+     * Constructor
+     */
+    SampleLog(LogStorage *storage);
+
+    /**
+     * Find the end of the log. Must be called before any other method.
+     *
+     * Returns false if the storage failed, in which case nothing is logged.
+     */
+    bool begin();
+
+    /**
+     * Take over the given number of the newest records written before
+     * begin(), e.g., as retained across a warm reset. To be called right
+     * after begin(); there may be fewer such records.
+     */
+    void keepNewest(uint16_t count);
+
+    /**
+     * Append a sample of SAMPLE_LOG_SAMPLE_SIZE bytes, taken at the given time.
+     *
+     * Returns false if the storage failed; the log then stops recording.
+     */
+    bool append(uint32_t time, const uint8_t *sample);
+
+    /**
+     * Number of records not discarded yet
+     */
+    uint16_t size();
+
+    /**
+     * Number of records the log retains at least; once it has to reuse a
+     * block, appending drops the oldest ones.
+     */
+    uint16_t capacity();
+
+    /**
+     * Read the record at the given position, 0 being the oldest.
+     *
+     * Returns false if there is no such record or the storage failed.
+     */
+    bool read(uint16_t position, sample_log_record_t *record);
+
+    /**
+     * Discard the given number of oldest records, e.g., once they have been sent.
+     */
+    void discardOldest(uint16_t count);
+
+  private:
+    LogStorage *storage;
+    bool ready;
+
+    uint16_t recordsPerBlock;
+    uint16_t numberOfSlots;
+    uint16_t head; // slot of the next record
+    uint16_t numberOfRecords;
+    uint16_t numberOfOldRecords; // found by begin()
+    uint16_t nextSequenceNumber;
+
+    bool readSlot(uint16_t slot, sample_log_record_t *record);
+};
+
+#endif /* SAMPLE_LOG_H */
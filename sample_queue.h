@@ -0,0 +1,113 @@
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <stdint.h>
+#include "sensor.h"
+
+/**
+ * Fixed-capacity ring buffer of samples, oldest first
+ *
+ * Holds the samples of several messages, so that a backlog can build up
+ * while uplinks are not possible, together with the times they were taken
+ * at and their sampling periods. If the queue is full, adding a sample
+ * overwrites the oldest one.
+ */
+template <uint8_t CAPACITY>
+class SampleQueue {
+  public:
+    /**
+     * Constructor
+     */
+    SampleQueue() {
+      head = 0;
+      numberOfSamples = 0;
+    }
+
+    uint8_t size() {
+      return numberOfSamples;
+    }
+
+    uint8_t capacity() {
+      return CAPACITY;
+    }
+
+    /**
+     * Append a sample taken at the given time in seconds, averaging the
+     * given sampling period.
+     *
+     * Returns false if the oldest sample had to be discarded.
+     */
+    bool push(clair_sample_t sample, uint32_t time, uint16_t samplingPeriodSeconds) {
+      bool full = numberOfSamples == CAPACITY;
+      samples[(head + numberOfSamples) % CAPACITY] = sample;
+      times[(head + numberOfSamples) % CAPACITY] = time;
+      samplingPeriods[(head + numberOfSamples) % CAPACITY] = samplingPeriodSeconds;
+      if (full) {
+        head = (head + 1) % CAPACITY;
+      } else {
+        numberOfSamples += 1;
+      }
+      return !full;
+    }
+
+    /**
+     * The sample at the given position, 0 being the oldest
+     */
+    clair_sample_t at(uint8_t position) {
+      return samples[(head + position) % CAPACITY];
+    }
+
+    /**
+     * The time of the sample at the given position
+     */
+    uint32_t timeAt(uint8_t position) {
+      return times[(head + position) % CAPACITY];
+    }
+
+    /**
+     * The sampling period of the sample at the given position
+     */
+    uint16_t samplingPeriodAt(uint8_t position) {
+      return samplingPeriods[(head + position) % CAPACITY];
+    }
+
+    /**
+     * Returns the number of oldest samples that share the sampling period of the oldest one.
+     */
+    uint8_t countEquispaced() {
+      uint8_t count = 0;
+      while (count < numberOfSamples && samplingPeriodAt(count) == samplingPeriodAt(0)) count++;
+      return count;
+    }
+
+    /**
+     * Copy the oldest samples to a contiguous buffer.
+     *
+     * Returns the number of samples copied.
+     */
+    uint8_t copyOldest(clair_sample_t *buffer, uint8_t maxNumberOfSamples) {
+      uint8_t count = numberOfSamples < maxNumberOfSamples ? numberOfSamples : maxNumberOfSamples;
+      for (uint8_t i = 0; i < count; i++) {
+        buffer[i] = at(i);
+      }
+      return count;
+    }
+
+    /**
+     * Remove the given number of oldest samples.
+     */
+    void discardOldest(uint8_t count) {
+      if (count > numberOfSamples) count = numberOfSamples;
+      head = (head + count) % CAPACITY;
+      numberOfSamples -= count;
+    }
+
+  private:
+    clair_sample_t samples[CAPACITY];
+    uint32_t times[CAPACITY];
+    uint16_t samplingPeriods[CAPACITY];
+    uint8_t head;
+    uint8_t numberOfSamples;
+};
+
+#endif /* SAMPLE_QUEUE_H */
@@ -6,6 +6,11 @@
 
 #define TOLERATED_NROF_CONSECUTIVE_ERRORS 3
 
+static int16_t toCentiUnits(float value) {
+  value *= 100;
+  return static_cast<int16_t>(value < 0 ? value - .5f : value + .5f);
+}
+
 Scd30Sensor::Scd30Sensor() {
   errorCounter = 0;
 }
@@ -32,11 +37,21 @@ clair_sample_t Scd30Sensor::sampleMeasurements() {
   // the SCD30 library always returns the latest measurement from its cache
   clair_sample_t newSample;
   newSample.co2ppm = scd30.getCO2();
-  newSample.temperature = scd30.getTemperature();
-  newSample.humidity = scd30.getHumidity();
+  // the SCD30 reports floats; convert them once, at the edge
+  newSample.temperatureCentiDegrees = toCentiUnits(scd30.getTemperature());
+  newSample.humidityCentiPercent = toCentiUnits(scd30.getHumidity());
   return newSample;
 }
 
 bool Scd30Sensor::measurementFailed() {
   return errorCounter > TOLERATED_NROF_CONSECUTIVE_ERRORS;
 }
+
+void Scd30Sensor::stopMeasuring() {
+  scd30.StopMeasurement();
+}
+
+void Scd30Sensor::startMeasuring() {
+  // the first measurement is available after one measurement interval (2 s)
+  scd30.beginMeasuring();
+}
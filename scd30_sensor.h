@@ -4,7 +4,7 @@
 #include "sensor.h"
 #include <SparkFun_SCD30_Arduino_Library.h>
 
-class Scd30Sensor: public Sensor {
+class Scd30Sensor final: public Sensor {
   public:
     Scd30Sensor();
 
@@ -16,6 +16,10 @@ class Scd30Sensor: public Sensor {
     clair_sample_t sampleMeasurements() override;
 
     bool measurementFailed() override;
+
+    void stopMeasuring() override;
+
+    void startMeasuring() override;
     
   private:
     SCD30 scd30;
@@ -3,10 +3,14 @@
 
 #include <stdint.h>
 
+/*
+ * Fixed-point measurements: temperature in 1/100 °C, relative humidity in
+ * 1/100 %. The Cortex-M0 has no FPU, so we avoid float arithmetic.
+ */
 typedef struct {
   uint16_t co2ppm;
-  float temperature;
-  float humidity;
+  int16_t temperatureCentiDegrees;
+  uint16_t humidityCentiPercent;
 } clair_sample_t;
 
 class Sensor {
@@ -25,6 +29,20 @@ class Sensor {
      * Return true if communication to the sensor failed.
      */
     virtual bool measurementFailed() = 0;
+
+    /**
+     * Put the sensor to sleep until startMeasuring() is called.
+     *
+     * Sensors without a low-power mode may ignore this.
+     */
+    virtual void stopMeasuring() {}
+
+    /**
+     * Resume measuring after stopMeasuring().
+     *
+     * Samples are available after a warm-up time of Config::SENSOR_WARMUP_SECS.
+     */
+    virtual void startMeasuring() {}
 };
 
 #endif /* SENSOR_H */
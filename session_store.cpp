@@ -0,0 +1,142 @@
+#include "session_store.h"
+#include "checksum.h"
+#include <string.h>
+
+/* bump this whenever lorawan_session_t changes, so that old checkpoints are ignored */
+#define SESSION_STORE_FORMAT 1
+
+/* sequence number (2 bytes), format, a reserved byte, the session, and a checksum (2 bytes) */
+#define SESSION_STORE_HEADER_SIZE 4
+#define SESSION_STORE_CHECKSUM_SIZE 2
+
+/* erased storage reads as all ones, so this sequence number marks free slots */
+#define FREE_SEQUENCE_NUMBER 0xFFFF
+
+SessionStore::SessionStore(LogStorage *storageArg) {
+  storage = storageArg;
+  ready = false;
+
+  slotSize = 0;
+  slotsPerBlock = 0;
+  numberOfSlots = 0;
+  nextSlot = 0;
+  nextSequenceNumber = 0;
+  stored = false;
+}
+
+static uint16_t nextAfter(uint16_t sequenceNumber) {
+  sequenceNumber += 1;
+  return sequenceNumber == FREE_SEQUENCE_NUMBER ? 0 : sequenceNumber;
+}
+
+// whether the sessions only differ in their frame and ADR acknowledgement counters
+static bool isSameSession(const lorawan_session_t &a, const lorawan_session_t &b) {
+  return a.netid == b.netid && a.devaddr == b.devaddr
+    && memcmp(a.nwkKey, b.nwkKey, sizeof(a.nwkKey)) == 0
+    && memcmp(a.artKey, b.artKey, sizeof(a.artKey)) == 0
+    && a.devNonce == b.devNonce
+    && a.datarate == b.datarate && a.adrTxPow == b.adrTxPow
+    && a.dn2Dr == b.dn2Dr && a.rx1DrOffset == b.rx1DrOffset && a.rxDelay == b.rxDelay
+    && a.channelMap == b.channelMap
+    && memcmp(a.channelFreq, b.channelFreq, sizeof(a.channelFreq)) == 0
+    && memcmp(a.channelDrMap, b.channelDrMap, sizeof(a.channelDrMap)) == 0;
+}
+
+bool SessionStore::readSlot(uint16_t slot, uint16_t *sequenceNumber, lorawan_session_t *session) {
+  uint8_t bytes[SESSION_STORE_HEADER_SIZE + sizeof(lorawan_session_t) + SESSION_STORE_CHECKSUM_SIZE];
+  if (!storage->read(static_cast<uint32_t>(slot) * slotSize, bytes, sizeof(bytes))) return false;
+
+  *sequenceNumber = bytes[0] | bytes[1] << 8;
+  if (*sequenceNumber == FREE_SEQUENCE_NUMBER || bytes[2] != SESSION_STORE_FORMAT) return false;
+
+  uint16_t checksumPosition = SESSION_STORE_HEADER_SIZE + sizeof(lorawan_session_t);
+  uint16_t checksum = bytes[checksumPosition] | bytes[checksumPosition + 1] << 8;
+  if (checksum != fletcher16(bytes, checksumPosition)) return false;
+
+  memcpy(session, bytes + SESSION_STORE_HEADER_SIZE, sizeof(lorawan_session_t));
+  return true;
+}
+
+bool SessionStore::begin() {
+  slotSize = (SESSION_STORE_HEADER_SIZE + sizeof(lorawan_session_t) + SESSION_STORE_CHECKSUM_SIZE + 3) / 4 * 4;
+  slotsPerBlock = storage->blockSize() / slotSize;
+  // the newest checkpoint must survive the erasure of the block for the next one
+  if (slotsPerBlock == 0 || storage->numberOfBlocks() < 2) return false;
+  numberOfSlots = slotsPerBlock * storage->numberOfBlocks();
+
+  // the newest checkpoint is the one furthest ahead of any other
+  stored = false;
+  uint16_t newestSlot = 0;
+  uint16_t newestSequenceNumber = 0;
+  for (uint16_t slot = 0; slot < numberOfSlots; slot++) {
+    uint16_t sequenceNumber;
+    lorawan_session_t session;
+    if (!readSlot(slot, &sequenceNumber, &session)) continue;
+
+    if (!stored || static_cast<int16_t>(sequenceNumber - newestSequenceNumber) > 0) {
+      newestSlot = slot;
+      newestSequenceNumber = sequenceNumber;
+      storedSession = session;
+      stored = true;
+    }
+  }
+
+  nextSlot = stored ? (newestSlot + 1) % numberOfSlots : 0;
+  nextSequenceNumber = stored ? nextAfter(newestSequenceNumber) : 0;
+  ready = true;
+  return true;
+}
+
+bool SessionStore::write(const lorawan_session_t &session) {
+  if (nextSlot % slotsPerBlock == 0 && !storage->erase(nextSlot / slotsPerBlock)) return false;
+
+  uint8_t bytes[SESSION_STORE_HEADER_SIZE + sizeof(lorawan_session_t) + SESSION_STORE_CHECKSUM_SIZE + 3];
+  memset(bytes, 0xFF, sizeof(bytes));
+  bytes[0] = nextSequenceNumber;
+  bytes[1] = nextSequenceNumber >> 8;
+  bytes[2] = SESSION_STORE_FORMAT;
+  bytes[3] = 0;
+  memcpy(bytes + SESSION_STORE_HEADER_SIZE, &session, sizeof(lorawan_session_t));
+  uint16_t checksumPosition = SESSION_STORE_HEADER_SIZE + sizeof(lorawan_session_t);
+  uint16_t checksum = fletcher16(bytes, checksumPosition);
+  bytes[checksumPosition] = checksum;
+  bytes[checksumPosition + 1] = checksum >> 8;
+
+  if (!storage->write(static_cast<uint32_t>(nextSlot) * slotSize, bytes, slotSize)) return false;
+
+  nextSlot = (nextSlot + 1) % numberOfSlots;
+  nextSequenceNumber = nextAfter(nextSequenceNumber);
+  storedSession = session;
+  stored = true;
+  return true;
+}
+
+bool SessionStore::restore(lorawan_session_t *session) {
+  // a session without a device address was checkpointed before any join
+  if (!ready || !stored || storedSession.devaddr == 0) return false;
+
+  *session = storedSession;
+  // uplinks may have been sent with any counter up to the next checkpoint
+  session->seqnoUp += SESSION_STORE_SEQNO_UP_INTERVAL;
+  // a second reset must not return to the same counter
+  return write(*session);
+}
+
+bool SessionStore::checkpoint(const lorawan_session_t &session) {
+  if (!ready) return false;
+  if (stored && isSameSession(session, storedSession)
+      && session.seqnoUp - storedSession.seqnoUp < SESSION_STORE_SEQNO_UP_INTERVAL) return true;
+
+  return write(session);
+}
+
+bool SessionStore::clear() {
+  if (!ready) return false;
+
+  for (uint16_t block = 0; block < storage->numberOfBlocks(); block++) {
+    if (!storage->erase(block)) return false;
+  }
+  nextSlot = 0;
+  stored = false;
+  return true;
+}
@@ -0,0 +1,96 @@
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <stdint.h>
+#include "log_storage.h"
+
+#define SESSION_STORE_MAX_CHANNELS 16
+
+/* the uplink counter is checkpointed at least this often, and skips this far ahead when restored */
+#define SESSION_STORE_SEQNO_UP_INTERVAL 64
+
+/**
+ * What a node needs to keep sending in a LoRaWAN session after a reset
+ */
+typedef struct {
+  uint32_t netid;
+  uint32_t devaddr;
+  uint8_t nwkKey[16];
+  uint8_t artKey[16];
+  uint32_t seqnoUp;
+  uint32_t seqnoDn;
+  uint16_t devNonce;
+  int16_t adrAckReq;
+  uint8_t datarate;
+  int8_t adrTxPow;
+  uint8_t dn2Dr;
+  uint8_t rx1DrOffset;
+  uint8_t rxDelay;
+  uint16_t channelMap;
+  uint32_t channelFreq[SESSION_STORE_MAX_CHANNELS];
+  uint16_t channelDrMap[SESSION_STORE_MAX_CHANNELS];
+} lorawan_session_t;
+
+/**
+ * Checkpoints of a LoRaWAN session in non-volatile memory
+ *
+ * Each checkpoint goes to the next slot of the storage, so that the blocks
+ * wear evenly, and carries a sequence number and a checksum, so that the
+ * newest complete checkpoint is found after a reset, even if power failed
+ * while it was being written.
+ *
+ * To keep flash writes to a minimum, a checkpoint is only written if the
+ * session has changed apart from its frame counters, or if the uplink
+ * counter has advanced by SESSION_STORE_SEQNO_UP_INTERVAL. The restored
+ * uplink counter skips that far ahead, so that it is never reused.
+ */
+class SessionStore {
+  public:
+    /**
+     * Constructor
+     */
+    SessionStore(LogStorage *storage);
+
+    /**
+     * Find the newest checkpoint. Must be called before any other method.
+     *
+     * Returns false if the storage is too small for checkpoints.
+     */
+    bool begin();
+
+    /**
+     * Returns false if there is no checkpoint, e.g., before the first join,
+     * or if its session has no device address.
+     */
+    bool restore(lorawan_session_t *session);
+
+    /**
+     * Write a checkpoint of the session if needed.
+     *
+     * Returns false if the storage failed.
+     */
+    bool checkpoint(const lorawan_session_t &session);
+
+    /**
+     * Forget the session, e.g., to join again.
+     */
+    bool clear();
+
+  private:
+    LogStorage *storage;
+    bool ready;
+
+    uint16_t slotSize;
+    uint16_t slotsPerBlock;
+    uint16_t numberOfSlots;
+    uint16_t nextSlot;
+    uint16_t nextSequenceNumber;
+
+    bool stored;
+    lorawan_session_t storedSession;
+
+    bool readSlot(uint16_t slot, uint16_t *sequenceNumber, lorawan_session_t *session);
+    bool write(const lorawan_session_t &session);
+};
+
+#endif /* SESSION_STORE_H */
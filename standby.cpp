@@ -0,0 +1,126 @@
+#ifdef ARDUINO_ARCH_SAMD
+
+#include "standby.h"
+#include <Arduino.h>
+
+/* the RTC counts the 32.768 kHz crystal, divided by 32 */
+#define RTC_TICKS_PER_SEC 1024
+#define GCLK_RTC 2
+
+// counts a millisecond of the Arduino core's clock, see cores/arduino/delay.c
+extern "C" void SysTick_DefaultHandler(void);
+
+// microseconds slept that have not been added to the core's clock yet
+static uint32_t sleptMicrosCarry;
+// the core's millisecond counter, if found
+static volatile uint32_t *tickCount;
+
+/*
+ * The core keeps its millisecond counter in a static variable of delay.c,
+ * which millis() loads through a PC-relative literal. Its address is taken
+ * from there, and only used if writing to it moves millis() accordingly.
+ */
+static volatile uint32_t *findTickCount() {
+  const uint16_t *code = reinterpret_cast<const uint16_t *>(reinterpret_cast<uint32_t>(&millis) & ~1UL);
+  for (uint8_t i = 0; i < 4; i++) {
+    // LDR Rt, [PC, #imm8 * 4]
+    if ((code[i] & 0xF800) != 0x4800) continue;
+    uint32_t literal = ((reinterpret_cast<uint32_t>(code + i) + 4) & ~3UL) + (code[i] & 0xFF) * 4;
+    uint32_t address = *reinterpret_cast<const uint32_t *>(literal);
+    if (address < HMCRAMC0_ADDR || address >= HMCRAMC0_ADDR + HMCRAMC0_SIZE || address % 4 != 0) return NULL;
+
+    volatile uint32_t *candidate = reinterpret_cast<volatile uint32_t *>(address);
+    __disable_irq();
+    uint32_t now = millis();
+    bool found = *candidate == now;
+    if (found) {
+      *candidate = now + 1;
+      found = millis() == now + 1;
+      *candidate = now;
+    }
+    __enable_irq();
+    return found ? candidate : NULL;
+  }
+  return NULL;
+}
+
+static void waitForRtcSync() {
+  while (RTC->MODE0.STATUS.bit.SYNCBUSY) {}
+}
+
+static uint32_t rtcCount() {
+  RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ | RTC_READREQ_ADDR(0x10);
+  waitForRtcSync();
+  return RTC->MODE0.COUNT.reg;
+}
+
+extern "C" void RTC_Handler(void) {
+  RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+}
+
+bool Standby::begin() {
+  // the core starts the crystal for the DFLL; it has to keep running in standby
+  SYSCTRL->XOSC32K.bit.RUNSTDBY = 1;
+
+  PM->APBAMASK.reg |= PM_APBAMASK_RTC;
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(GCLK_RTC) | GCLK_GENDIV_DIV(4);
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+  // divides by 2^(DIV + 1)
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(GCLK_RTC) | GCLK_GENCTRL_SRC_XOSC32K | GCLK_GENCTRL_DIVSEL
+      | GCLK_GENCTRL_RUNSTDBY | GCLK_GENCTRL_GENEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC | GCLK_CLKCTRL_GEN(GCLK_RTC) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_SWRST;
+  while (RTC->MODE0.CTRL.bit.SWRST) {}
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32 | RTC_MODE0_CTRL_PRESCALER_DIV1;
+  waitForRtcSync();
+  RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_CMP0;
+  NVIC_EnableIRQ(RTC_IRQn);
+  RTC->MODE0.CTRL.bit.ENABLE = 1;
+  waitForRtcSync();
+
+  tickCount = findTickCount();
+  if (tickCount == NULL) {
+    PRINTLN(F("WARNING: millis() counter not found, catching up the clock a millisecond at a time"));
+  }
+  return true;
+}
+
+uint32_t Standby::sleepMillis(uint32_t millis) {
+  if (millis < STANDBY_MIN_MILLIS) return 0;
+
+  uint32_t start = rtcCount();
+  // rounded down, so that the MCU wakes up before the deadline rather than after it
+  uint32_t ticks = static_cast<uint64_t>(millis) * RTC_TICKS_PER_SEC / 1000;
+  RTC->MODE0.COMP[0].reg = start + ticks;
+  waitForRtcSync();
+  RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+
+  // any interrupt ends the standby, but its handler only runs once the clock has caught up, so that LMIC's DIO handlers stamp the right time
+  __disable_irq();
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  // errata: a pending SysTick interrupt would end the standby right away
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+  __DSB();
+  __WFI();
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+  uint32_t sleptMicros = static_cast<uint64_t>(rtcCount() - start) * 1000000 / RTC_TICKS_PER_SEC + sleptMicrosCarry;
+  uint32_t sleptMillis = sleptMicros / 1000;
+  sleptMicrosCarry = sleptMicros % 1000;
+  if (tickCount != NULL) {
+    // in one step; the countdown of a reset requested over USB, which SysTick_DefaultHandler() also runs, waits
+    *tickCount += sleptMillis;
+  } else {
+    for (uint32_t i = 0; i < sleptMillis; i++) {
+      SysTick_DefaultHandler();
+    }
+  }
+  __enable_irq();
+  return sleptMillis;
+}
+
+#endif /* ARDUINO_ARCH_SAMD */
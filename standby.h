@@ -0,0 +1,42 @@
+#ifndef STANDBY_H
+#define STANDBY_H
+
+#include <stdint.h>
+#include "debug.h"
+
+/*
+ * If 1, the node spends the time between LMIC jobs in standby. USB, and with
+ * it Serial, stops in standby, so debug builds stay awake by default.
+ */
+#ifndef CLAIR_DEEP_SLEEP
+#define CLAIR_DEEP_SLEEP (!DEBUG)
+#endif
+
+/* shorter naps do not pay for waking up the 32 kHz domain and catching up the clock */
+#define STANDBY_MIN_MILLIS 10
+
+/**
+ * Standby of the SAMD21, with the RTC as alarm clock
+ *
+ * In standby, the SysTick stops, and with it millis(), micros(), and LMIC's
+ * os_getTime(). After waking up, the time spent asleep, as counted by the
+ * RTC, is added to the Arduino core's clock in one step, so that LMIC's
+ * deadlines and the duty cycle of its bands stay right.
+ */
+class Standby {
+  public:
+    /**
+     * Set up the RTC. Returns false if it is not available.
+     */
+    bool begin();
+
+    /**
+     * Sleep for at most the given number of milliseconds.
+     *
+     * Returns how long the MCU actually slept, in milliseconds; 0 if it did
+     * not, e.g., because the nap would be shorter than STANDBY_MIN_MILLIS.
+     */
+    uint32_t sleepMillis(uint32_t millis);
+};
+
+#endif /* STANDBY_H */
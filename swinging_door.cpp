@@ -0,0 +1,88 @@
+#include "swinging_door.h"
+
+SwingingDoor::SwingingDoor(uint16_t deviationPpmArg, uint32_t maxSpanSecsArg) {
+  deviationPpm = deviationPpmArg;
+  maxSpanSecs = maxSpanSecsArg;
+  started = false;
+}
+
+// a / b < c / d for positive b and d
+static bool slopeIsLess(int32_t a, uint32_t b, int32_t c, uint32_t d) {
+  return static_cast<int64_t>(a) * d < static_cast<int64_t>(c) * b;
+}
+
+void SwingingDoor::restartAtLastReading() {
+  originTime = lastTime;
+  origin = last;
+}
+
+// the doors through the given reading, pivoting at the origin
+void SwingingDoor::openDoors(uint32_t time, clair_sample_t reading) {
+  int32_t difference = static_cast<int32_t>(reading.co2ppm) - origin.co2ppm;
+  upperSlopePpm = difference + deviationPpm;
+  lowerSlopePpm = difference - deviationPpm;
+  upperSlopeSecs = lowerSlopeSecs = time - originTime;
+
+  lastTime = time;
+  last = reading;
+}
+
+bool SwingingDoor::add(uint32_t time, clair_sample_t reading, clair_sample_t *breakpoint, uint32_t *breakpointTime) {
+  if (!started) {
+    started = true;
+    originTime = lastTime = time;
+    origin = last = reading;
+    *breakpoint = reading;
+    *breakpointTime = time;
+    return true;
+  }
+  if (time == originTime) return false;
+
+  if (lastTime == originTime) {
+    openDoors(time, reading);
+    return false;
+  }
+
+  int32_t difference = static_cast<int32_t>(reading.co2ppm) - origin.co2ppm;
+  int32_t upperPpm = difference + deviationPpm;
+  int32_t lowerPpm = difference - deviationPpm;
+  uint32_t secs = time - originTime;
+
+  bool spanExceeded = secs > maxSpanSecs;
+  bool doorsClosed = slopeIsLess(upperPpm, secs, lowerSlopePpm, lowerSlopeSecs)
+    || slopeIsLess(upperSlopePpm, upperSlopeSecs, lowerPpm, secs);
+
+  if (spanExceeded || doorsClosed) {
+    *breakpoint = last;
+    *breakpointTime = lastTime;
+    restartAtLastReading();
+    openDoors(time, reading);
+    return true;
+  }
+
+  // narrow the doors
+  if (slopeIsLess(upperPpm, secs, upperSlopePpm, upperSlopeSecs)) {
+    upperSlopePpm = upperPpm;
+    upperSlopeSecs = secs;
+  }
+  if (slopeIsLess(lowerSlopePpm, lowerSlopeSecs, lowerPpm, secs)) {
+    lowerSlopePpm = lowerPpm;
+    lowerSlopeSecs = secs;
+  }
+  lastTime = time;
+  last = reading;
+  return false;
+}
+
+bool SwingingDoor::hasPendingReadings() {
+  return started && lastTime != originTime;
+}
+
+bool SwingingDoor::flush(clair_sample_t *breakpoint, uint32_t *breakpointTime) {
+  if (!hasPendingReadings()) return false;
+
+  *breakpoint = last;
+  *breakpointTime = lastTime;
+  restartAtLastReading();
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SWINGING_DOOR_H
+#define SWINGING_DOOR_H
+
+#include <stdint.h>
+#include "sensor.h"
+
+/**
+ * Swinging-door compression of the CO2 readings
+ *
+ * Approximates the series of readings by straight lines between breakpoints,
+ * so that no reading deviates from the line by more than the given number
+ * of ppm. Temperature and humidity are carried along with the breakpoints.
+ * A breakpoint is also archived when the door has been open for maxSpanSecs.
+ */
+class SwingingDoor {
+  public:
+    /**
+     * Constructor
+     */
+    SwingingDoor(uint16_t deviationPpm, uint32_t maxSpanSecs);
+
+    /**
+     * Add a reading taken at the given time in seconds.
+     *
+     * Returns true if a breakpoint has been archived, which is then stored in
+     * breakpoint and breakpointTime. The first reading is always a breakpoint.
+     */
+    bool add(uint32_t time, clair_sample_t reading, clair_sample_t *breakpoint, uint32_t *breakpointTime);
+
+    /**
+     * Returns whether there are readings since the last breakpoint.
+     */
+    bool hasPendingReadings();
+
+    /**
+     * Archive the latest reading as a breakpoint, e.g., before transmission.
+     *
+     * Returns false if there are no readings since the last breakpoint.
+     */
+    bool flush(clair_sample_t *breakpoint, uint32_t *breakpointTime);
+
+  private:
+    uint16_t deviationPpm;
+    uint32_t maxSpanSecs;
+
+    bool started;
+    uint32_t originTime;
+    clair_sample_t origin;
+    uint32_t lastTime;
+    clair_sample_t last;
+
+    /* slopes of the upper and lower door, as a number of ppm per number of seconds */
+    int32_t upperSlopePpm;
+    uint32_t upperSlopeSecs;
+    int32_t lowerSlopePpm;
+    uint32_t lowerSlopeSecs;
+
+    void restartAtLastReading();
+    void openDoors(uint32_t time, clair_sample_t reading);
+};
+
+#endif /* SWINGING_DOOR_H */
@@ -0,0 +1,110 @@
+#ifdef ARDUINO_ARCH_SAMD
+
+#include "tcc_led_timer.h"
+#include <Arduino.h>
+
+/* the same clock as the RTC of the standby, but a generator of its own, so that it also runs without */
+#define GCLK_LED_TIMER 4
+/* LED_BUILTIN is PA17, which is TCC2/WO[1] with peripheral function E */
+#define LED_PORT_PIN 17
+#define LED_TCC_CHANNEL 1
+#define LED_DMA_CHANNEL 0
+
+// the DMAC reads the descriptor of channel n from the nth entry, which has to be 128-bit aligned
+__attribute__((aligned(16))) static DmacDescriptor descriptors[LED_DMA_CHANNEL + 1];
+__attribute__((aligned(16))) static DmacDescriptor writeback[LED_DMA_CHANNEL + 1];
+static uint32_t compareValues[LED_TIMER_MAX_PATTERN];
+
+static void waitForTccSync() {
+  while (TCC2->SYNCBUSY.reg) {}
+}
+
+static void stopDma() {
+  DMAC->CHID.reg = DMAC_CHID_ID(LED_DMA_CHANNEL);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  while (DMAC->CHCTRLA.bit.ENABLE) {}
+}
+
+void TccLedTimer::begin() {
+  // the core starts the crystal for the DFLL; it has to keep running in standby
+  SYSCTRL->XOSC32K.bit.RUNSTDBY = 1;
+
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(GCLK_LED_TIMER) | GCLK_GENDIV_DIV(4);
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+  // divides by 2^(DIV + 1)
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(GCLK_LED_TIMER) | GCLK_GENCTRL_SRC_XOSC32K | GCLK_GENCTRL_DIVSEL
+      | GCLK_GENCTRL_RUNSTDBY | GCLK_GENCTRL_GENEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3 | GCLK_CLKCTRL_GEN(GCLK_LED_TIMER) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY) {}
+
+  PM->APBCMASK.reg |= PM_APBCMASK_TCC2;
+  TCC2->CTRLA.reg = TCC_CTRLA_SWRST;
+  while (TCC2->SYNCBUSY.bit.SWRST) {}
+  // the output is high from the start of each cycle until the counter reaches the compare value
+  TCC2->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+  waitForTccSync();
+  TCC2->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV1 | TCC_CTRLA_RUNSTDBY;
+
+  // nothing else in the firmware uses the DMAC
+  PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+  PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+  DMAC->CTRL.reg = 0;
+  DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+  while (DMAC->CTRL.bit.SWRST) {}
+  DMAC->BASEADDR.reg = reinterpret_cast<uint32_t>(descriptors);
+  DMAC->WRBADDR.reg = reinterpret_cast<uint32_t>(writeback);
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+
+  PORT->Group[0].PMUX[LED_PORT_PIN >> 1].bit.PMUXO = PORT_PMUX_PMUXO_E_Val;
+  PORT->Group[0].PINCFG[LED_PORT_PIN].bit.PMUXEN = 1;
+}
+
+void TccLedTimer::play(const led_pattern_t &pattern) {
+  uint8_t length = pattern.length;
+  if (length == 0) return;
+  if (length > LED_TIMER_MAX_PATTERN) length = LED_TIMER_MAX_PATTERN;
+
+  TCC2->CTRLA.bit.ENABLE = 0;
+  waitForTccSync();
+  stopDma();
+
+  TCC2->PER.reg = pattern.period;
+  TCC2->COUNT.reg = 0;
+  TCC2->CC[LED_TCC_CHANNEL].reg = pattern.compare[0];
+  waitForTccSync();
+
+  if (length > 1) {
+    /*
+     * On each overflow, the TCC takes over the buffered compare value, and
+     * the DMA channel then buffers the one of the cycle after the next. The
+     * first two come from the CPU, so the channel's loop starts with the third.
+     */
+    TCC2->CCB[LED_TCC_CHANNEL].reg = pattern.compare[1];
+    waitForTccSync();
+    for (uint8_t i = 0; i < length; i++) {
+      compareValues[i] = pattern.compare[(i + 2) % length];
+    }
+
+    DmacDescriptor *descriptor = &descriptors[LED_DMA_CHANNEL];
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_SRCINC
+        | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor->BTCNT.reg = length;
+    // the end of the block, as the source address is incremented
+    descriptor->SRCADDR.reg = reinterpret_cast<uint32_t>(compareValues + length);
+    descriptor->DSTADDR.reg = reinterpret_cast<uint32_t>(&TCC2->CCB[LED_TCC_CHANNEL].reg);
+    // the descriptor links to itself, so that the pattern repeats
+    descriptor->DESCADDR.reg = reinterpret_cast<uint32_t>(descriptor);
+
+    DMAC->CHID.reg = DMAC_CHID_ID(LED_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.bit.SWRST) {}
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(TCC2_DMAC_ID_OVF) | DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+  }
+
+  TCC2->CTRLA.bit.ENABLE = 1;
+  waitForTccSync();
+}
+
+#endif /* ARDUINO_ARCH_SAMD */
@@ -0,0 +1,20 @@
+#ifndef TCC_LED_TIMER_H
+#define TCC_LED_TIMER_H
+
+#include "led_timer.h"
+
+/**
+ * LedTimer on TCC2 of the SAMD21, whose output WO[1] drives PA17, the
+ * Feather M0's LED_BUILTIN
+ *
+ * The counter runs in standby. If the compare value changes from cycle to
+ * cycle, a DMA channel reloads it on each overflow, so that the CPU does not
+ * have to wake up for error bursts either.
+ */
+class TccLedTimer final : public LedTimer {
+  public:
+    void begin() override;
+    void play(const led_pattern_t &pattern) override;
+};
+
+#endif /* TCC_LED_TIMER_H */
@@ -0,0 +1,45 @@
+#ifndef FAKE_LED_TIMER_H
+#define FAKE_LED_TIMER_H
+
+#include "led_timer.h"
+
+/**
+ * LedTimer for host tests, which keeps the register values and tells the
+ * level of the LED they produce at any time after they were set
+ */
+class FakeLedTimer final : public LedTimer {
+  public:
+    FakeLedTimer() {
+      begun = false;
+      plays = 0;
+      pattern.period = 0;
+      pattern.length = 0;
+    }
+
+    void begin() override {
+      begun = true;
+    }
+
+    void play(const led_pattern_t &patternArg) override {
+      pattern = patternArg;
+      plays += 1;
+    }
+
+    /**
+     * Whether the LED is on the given number of milliseconds after the
+     * pattern started
+     */
+    bool isOn(uint32_t millis) const {
+      if (pattern.length == 0) return false;
+      uint64_t ticks = static_cast<uint64_t>(millis) * LED_TIMER_TICKS_PER_SEC / 1000;
+      uint64_t cycle = ticks / (pattern.period + 1U);
+      uint64_t count = ticks % (pattern.period + 1U);
+      return count < pattern.compare[cycle % pattern.length];
+    }
+
+    bool begun;
+    int plays;
+    led_pattern_t pattern;
+};
+
+#endif /* FAKE_LED_TIMER_H */
@@ -0,0 +1,60 @@
+#ifndef RAM_LOG_STORAGE_H
+#define RAM_LOG_STORAGE_H
+
+#include "log_storage.h"
+#include <string.h>
+#include <vector>
+
+/**
+ * LogStorage in RAM for host tests, with the semantics of NOR flash:
+ * writes can only clear bits, and erasing sets a block to 0xFF.
+ * Erasing a fresh storage is not required, it starts out erased.
+ */
+class RamLogStorage final : public LogStorage {
+  public:
+    RamLogStorage(uint16_t blockSizeArg, uint16_t numberOfBlocksArg) {
+      memory.assign(static_cast<size_t>(blockSizeArg) * numberOfBlocksArg, 0xFF);
+      erases.assign(numberOfBlocksArg, 0);
+      size = blockSizeArg;
+      failing = false;
+    }
+
+    uint16_t blockSize() override {
+      return size;
+    }
+
+    uint16_t numberOfBlocks() override {
+      return erases.size();
+    }
+
+    bool read(uint32_t address, uint8_t *data, uint16_t length) override {
+      if (failing || address + length > memory.size()) return false;
+      memcpy(data, &memory[address], length);
+      return true;
+    }
+
+    bool write(uint32_t address, const uint8_t *data, uint16_t length) override {
+      if (failing || address + length > memory.size() || address % 4 != 0 || length % 4 != 0) return false;
+      for (uint16_t i = 0; i < length; i++) memory[address + i] &= data[i];
+      return true;
+    }
+
+    bool erase(uint16_t block) override {
+      if (failing || block >= erases.size()) return false;
+      memset(&memory[static_cast<size_t>(block) * size], 0xFF, size);
+      erases[block] += 1;
+      return true;
+    }
+
+    /* number of times each block has been erased */
+    std::vector<uint32_t> erases;
+
+    /* let all operations fail, like a broken flash */
+    bool failing;
+
+  private:
+    uint16_t size;
+    std::vector<uint8_t> memory;
+};
+
+#endif /* RAM_LOG_STORAGE_H */
@@ -0,0 +1,72 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/*
+ * Host stand-in for the subset of the Arduino core used by Clairchen.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define LED_BUILTIN 13
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PROGMEM
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(STRING_LITERAL) (reinterpret_cast<const __FlashStringHelper *>(STRING_LITERAL))
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+
+class SimSerial {
+  public:
+    void begin(unsigned long baud) { (void) (baud); }
+    void flush() { }
+    operator bool() { return true; }
+
+    size_t print(const __FlashStringHelper *string);
+    size_t print(const char *string);
+    size_t print(char c);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+    size_t print(unsigned int value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+    size_t print(short value, int base = DEC) { return print(static_cast<long>(value), base); }
+    size_t print(unsigned short value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+    size_t print(unsigned char value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+    size_t print(signed char value, int base = DEC) { return print(static_cast<long>(value), base); }
+    size_t print(double value, int digits = 2);
+
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + print('\n'); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + print('\n'); }
+    size_t println() { return print('\n'); }
+};
+
+extern SimSerial Serial;
+
+#endif /* ARDUINO_H */
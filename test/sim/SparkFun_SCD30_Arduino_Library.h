@@ -0,0 +1,43 @@
+#ifndef SPARKFUN_SCD30_ARDUINO_LIBRARY_H
+#define SPARKFUN_SCD30_ARDUINO_LIBRARY_H
+
+/*
+ * Host stand-in for the SparkFun SCD30 library.
+ *
+ * Readings follow a simple office room model driven by the virtual clock:
+ * CO2 builds up during working hours on weekdays and decays at night.
+ * Like the real sensor, a new measurement is only available every
+ * measurement interval (2 s by default) while continuous measurement runs.
+ */
+
+#include <Wire.h>
+#include <stdint.h>
+
+class SCD30 {
+  public:
+    bool begin(bool autoCalibrate = true);
+    bool begin(TwoWire &wirePort, bool autoCalibrate = true) { (void) (wirePort); return begin(autoCalibrate); }
+
+    bool beginMeasuring();
+    bool StopMeasurement();
+    bool setMeasurementInterval(uint16_t interval);
+
+    bool dataAvailable();
+    bool readMeasurement();
+
+    uint16_t getCO2();
+    float getTemperature();
+    float getHumidity();
+
+  private:
+    bool measuring = false;
+    uint16_t intervalSecs = 2;
+    uint64_t measuringSinceUs = 0;
+    uint64_t lastReadUs = 0;
+    bool fresh[3] = { false, false, false };
+    uint16_t co2 = 0;
+    float temperature = 0;
+    float humidity = 0;
+};
+
+#endif /* SPARKFUN_SCD30_ARDUINO_LIBRARY_H */
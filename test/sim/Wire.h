@@ -0,0 +1,16 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+/*
+ * Host stand-in for the Arduino Wire library. The simulated SCD30 does not
+ * talk I2C, so the bus only records whether it has been started.
+ */
+class TwoWire {
+  public:
+    void begin() { started = true; }
+    bool started = false;
+};
+
+extern TwoWire Wire;
+
+#endif /* WIRE_H */
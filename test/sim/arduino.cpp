@@ -0,0 +1,117 @@
+#include "sim.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include <arduino_lmic_hal_boards.h>
+#include <stdio.h>
+
+SimSerial Serial;
+TwoWire Wire;
+
+/*
+ * Serial is USB on the Feather M0; assume that each write waits for a frame of
+ * its own. The output costs time whether or not it is forwarded to stdout.
+ */
+#define SERIAL_WRITE_US 1000
+
+static bool verbose;
+static int ledValue = LOW;
+
+namespace sim {
+
+void setSerialVerbose(bool enabled) {
+  verbose = enabled;
+}
+
+}
+
+void pinMode(uint32_t pin, uint32_t mode) {
+  (void) (pin);
+  (void) (mode);
+}
+
+void digitalWrite(uint32_t pin, uint32_t value) {
+  if (pin == LED_BUILTIN && static_cast<int>(value) != ledValue) {
+    ledValue = value;
+    sim::onLedWrite(value);
+  }
+}
+
+int digitalRead(uint32_t pin) {
+  return pin == LED_BUILTIN ? ledValue : LOW;
+}
+
+void delay(unsigned long ms) {
+  sim::advanceUs(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  sim::advanceUs(us);
+}
+
+unsigned long millis() {
+  return static_cast<unsigned long>(sim::nowUs() / 1000);
+}
+
+unsigned long micros() {
+  return static_cast<unsigned long>(sim::nowUs());
+}
+
+size_t SimSerial::print(const __FlashStringHelper *string) {
+  return print(reinterpret_cast<const char *>(string));
+}
+
+size_t SimSerial::print(const char *string) {
+  sim::advanceUs(SERIAL_WRITE_US);
+  if (!verbose) return strlen(string);
+  return fputs(string, stdout) < 0 ? 0 : strlen(string);
+}
+
+size_t SimSerial::print(char c) {
+  sim::advanceUs(SERIAL_WRITE_US);
+  if (verbose) putchar(c);
+  return 1;
+}
+
+size_t SimSerial::print(long value, int base) {
+  if (value < 0 && base == DEC) {
+    print('-');
+    return print(static_cast<unsigned long>(-value), base) + 1;
+  }
+  return print(static_cast<unsigned long>(value), base);
+}
+
+size_t SimSerial::print(unsigned long value, int base) {
+  char digits[8 * sizeof(value) + 1];
+  char *position = &digits[sizeof(digits) - 1];
+  *position = '\0';
+  do {
+    unsigned long digit = value % base;
+    *--position = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value != 0);
+  return print(position);
+}
+
+size_t SimSerial::print(double value, int digits) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return print(buffer);
+}
+
+namespace Arduino_LMIC {
+
+static const HalPinmap_t featherM0Pins = {
+  .nss = 8,
+  .rxtx = LMIC_UNUSED_PIN,
+  .rst = 4,
+  .dio = {3, 6, LMIC_UNUSED_PIN},
+  .rxtx_rx_active = 0,
+  .rssi_cal = 8,
+  .spi_freq = 8000000
+};
+
+const HalPinmap_t *GetPinmap_ThisBoard() {
+  return &featherM0Pins;
+}
+
+}
@@ -0,0 +1,6 @@
+#ifndef ARDUINO_LMIC_H
+#define ARDUINO_LMIC_H
+
+#include "lmic/lmic.h"
+
+#endif /* ARDUINO_LMIC_H */
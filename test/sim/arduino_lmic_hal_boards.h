@@ -0,0 +1,14 @@
+#ifndef ARDUINO_LMIC_HAL_BOARDS_H
+#define ARDUINO_LMIC_HAL_BOARDS_H
+
+#include "hal/hal.h"
+
+namespace Arduino_LMIC {
+
+typedef lmic_pinmap HalPinmap_t;
+
+const HalPinmap_t *GetPinmap_ThisBoard();
+
+}
+
+#endif /* ARDUINO_LMIC_HAL_BOARDS_H */
@@ -0,0 +1,201 @@
+/*
+ * Runs a fleet of Clairchen nodes in virtual time, all powered up at the same
+ * instant within reach of one gateway, and reports which share of their
+ * uplinks survives collisions as the fleet grows.
+ *
+ * Each node runs in a process of its own, with its own DevEUI and seed. Two
+ * uplinks collide if they overlap in time on the same channel at the same
+ * datarate; the gateway receives neither of them.
+ *
+ * Usage: clairchen-collisions [--days N] [--datarate DR] [--nodes N ...]
+ */
+
+#include "sim.h"
+#include "transmission_jitter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+// DevEUIs of a production batch are consecutive
+#define FIRST_DEVEUI 0x0004A30B001C0000ULL
+
+typedef struct {
+  uint64_t timeUs;
+  uint32_t airtimeUs;
+  uint8_t datarate;
+  uint8_t channel;
+} transmission_t;
+
+static void usage(const char *program) {
+  fprintf(stderr, "usage: %s [--days N] [--datarate DR] [--nodes N ...]\n", program);
+  exit(2);
+}
+
+static bool writeAll(int fd, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written <= 0) return false;
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+/*
+ * Simulates one node in a child process, which writes the node's uplinks to
+ * the returned file descriptor.
+ */
+static int startNode(unsigned node, unsigned days, int datarate) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(1);
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (pid > 0) {
+    close(fds[1]);
+    return fds[0];
+  }
+
+  close(fds[0]);
+  sim::options_t options;
+  options.datarate = datarate;
+  options.adrWalk = false;
+  options.seed = node + 1;
+  options.verbose = false;
+  options.devEui = FIRST_DEVEUI + node;
+  options.pollRadio = false;
+  options.outageStartSecs = 0;
+  options.outageSecs = 0;
+  sim::configure(options);
+  sim::runUntil(SIM_DAYS(days));
+
+  const std::vector<sim::uplink_t> &uplinks = sim::uplinks();
+  for (size_t i = 0; i < uplinks.size(); i++) {
+    transmission_t transmission;
+    transmission.timeUs = uplinks[i].timeUs;
+    transmission.airtimeUs = uplinks[i].airtimeUs;
+    transmission.datarate = uplinks[i].datarate;
+    transmission.channel = uplinks[i].channel;
+    if (!writeAll(fds[1], &transmission, sizeof(transmission))) _exit(1);
+  }
+  _exit(0);
+}
+
+static std::vector<transmission_t> readTransmissions(int fd) {
+  std::vector<transmission_t> transmissions;
+  transmission_t transmission;
+  size_t filled = 0;
+  for (;;) {
+    ssize_t n = read(fd, reinterpret_cast<uint8_t *>(&transmission) + filled, sizeof(transmission) - filled);
+    if (n <= 0) break;
+    filled += n;
+    if (filled == sizeof(transmission)) {
+      transmissions.push_back(transmission);
+      filled = 0;
+    }
+  }
+  close(fd);
+  return transmissions;
+}
+
+static bool overlap(const transmission_t &a, const transmission_t &b) {
+  return a.channel == b.channel && a.datarate == b.datarate
+      && a.timeUs < b.timeUs + b.airtimeUs && b.timeUs < a.timeUs + a.airtimeUs;
+}
+
+/*
+ * Number of transmissions of the first nrofNodes nodes that do not overlap
+ * with a transmission of another one of them
+ */
+static uint64_t countDelivered(const std::vector<std::vector<transmission_t> > &nodes, unsigned nrofNodes) {
+  uint64_t delivered = 0;
+  for (unsigned node = 0; node < nrofNodes; node++) {
+    for (size_t i = 0; i < nodes[node].size(); i++) {
+      bool collided = false;
+      for (unsigned other = 0; other < nrofNodes && !collided; other++) {
+        if (other == node) continue;
+        for (size_t j = 0; j < nodes[other].size() && !collided; j++) {
+          collided = overlap(nodes[node][i], nodes[other][j]);
+        }
+      }
+      if (!collided) delivered += 1;
+    }
+  }
+  return delivered;
+}
+
+int main(int argc, char **argv) {
+  unsigned days = 1;
+  int datarate = -1;
+  std::vector<unsigned> densities;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+      days = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--datarate") == 0 && i + 1 < argc) {
+      datarate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+      while (i + 1 < argc && argv[i + 1][0] != '-') {
+        unsigned nrofNodes = atoi(argv[++i]);
+        if (nrofNodes == 0) usage(argv[0]);
+        densities.push_back(nrofNodes);
+      }
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (days == 0) usage(argv[0]);
+  if (densities.empty()) {
+    densities.push_back(1);
+    densities.push_back(10);
+    densities.push_back(50);
+    densities.push_back(100);
+  }
+
+  unsigned maxNodes = 0;
+  for (size_t i = 0; i < densities.size(); i++) {
+    if (densities[i] > maxNodes) maxNodes = densities[i];
+  }
+
+  // all nodes run at once; the pipes are drained one after the other
+  std::vector<int> fds;
+  for (unsigned node = 0; node < maxNodes; node++) {
+    fds.push_back(startNode(node, days, datarate));
+  }
+  std::vector<std::vector<transmission_t> > nodes;
+  for (unsigned node = 0; node < maxNodes; node++) {
+    nodes.push_back(readTransmissions(fds[node]));
+  }
+  bool failed = false;
+  int status;
+  while (wait(&status) > 0) {
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+  }
+  if (failed) {
+    fprintf(stderr, "a node failed\n");
+    return 1;
+  }
+
+  printf("transmission jitter: %s, simulated days: %u\n", CLAIR_TX_JITTER ? "on" : "off", days);
+  printf("nodes  uplinks  delivered  PDR\n");
+  for (size_t i = 0; i < densities.size(); i++) {
+    uint64_t uplinks = 0;
+    for (unsigned node = 0; node < densities[i]; node++) {
+      uplinks += nodes[node].size();
+    }
+    uint64_t delivered = countDelivered(nodes, densities[i]);
+    printf("%5u  %7llu  %9llu  %5.1f %%\n", densities[i], (unsigned long long) uplinks,
+        (unsigned long long) delivered, uplinks > 0 ? 100.0 * delivered / uplinks : 0.0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,6 @@
+// The simulated node uses the keys of Mr. Black, but a DevEUI of its own, see sim::options_t.
+#include "sim.h"
+#define DEVEUI BLACK_DEVEUI
+#include "euis_black.h"
+#undef DEVEUI
+#define DEVEUI sim::devEui()
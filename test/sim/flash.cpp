@@ -0,0 +1,37 @@
+#include "flash_log_storage.h"
+#include "../ram_log_storage.h"
+
+/*
+ * The flash of the Feather M0, in RAM. Like on the board, the log area
+ * starts out erased and keeps its contents for the whole run.
+ */
+static RamLogStorage flash(FLASH_LOG_STORAGE_ROW_SIZE, FLASH_LOG_STORAGE_SIZE / FLASH_LOG_STORAGE_ROW_SIZE);
+
+FlashLogStorage::FlashLogStorage(uint16_t firstRow, uint16_t numberOfRows) {
+  offset = static_cast<uint32_t>(firstRow) * FLASH_LOG_STORAGE_ROW_SIZE;
+  size = static_cast<uint32_t>(numberOfRows) * FLASH_LOG_STORAGE_ROW_SIZE;
+  if (offset + size > FLASH_LOG_STORAGE_SIZE) size = 0;
+}
+
+uint16_t FlashLogStorage::blockSize() {
+  return FLASH_LOG_STORAGE_ROW_SIZE;
+}
+
+uint16_t FlashLogStorage::numberOfBlocks() {
+  return size / FLASH_LOG_STORAGE_ROW_SIZE;
+}
+
+bool FlashLogStorage::read(uint32_t address, uint8_t *data, uint16_t length) {
+  if (address + length > size) return false;
+  return flash.read(offset + address, data, length);
+}
+
+bool FlashLogStorage::write(uint32_t address, const uint8_t *data, uint16_t length) {
+  if (address + length > size) return false;
+  return flash.write(offset + address, data, length);
+}
+
+bool FlashLogStorage::erase(uint16_t block) {
+  if (block >= numberOfBlocks()) return false;
+  return flash.erase(offset / FLASH_LOG_STORAGE_ROW_SIZE + block);
+}
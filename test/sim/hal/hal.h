@@ -0,0 +1,18 @@
+#ifndef HAL_HAL_H
+#define HAL_HAL_H
+
+#include <stdint.h>
+
+#define LMIC_UNUSED_PIN 0xff
+
+struct lmic_pinmap {
+  uint8_t nss;
+  uint8_t rxtx;
+  uint8_t rst;
+  uint8_t dio[3];
+  uint8_t rxtx_rx_active;
+  int8_t rssi_cal;
+  uint32_t spi_freq;
+};
+
+#endif /* HAL_HAL_H */
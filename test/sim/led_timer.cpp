@@ -0,0 +1,15 @@
+#include "tcc_led_timer.h"
+#include "sim.h"
+
+/*
+ * The TCC of the Feather M0 blinks the LED without the CPU, so the
+ * simulation only counts how often the firmware reprograms it.
+ */
+
+void TccLedTimer::begin() {
+}
+
+void TccLedTimer::play(const led_pattern_t &pattern) {
+  (void) (pattern);
+  sim::counters().ledPatterns += 1;
+}
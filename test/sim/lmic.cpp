@@ -0,0 +1,468 @@
+#include "sim.h"
+#include "airtime.h"
+#include <lmic/lmic.h>
+#include <string.h>
+#include <vector>
+
+struct lmic_t LMIC;
+
+#define US_PER_OSTICK (1000000 / OSTICKS_PER_SEC)
+
+#define JOIN_REQUEST_SIZE 23
+#define JOIN_ACCEPT_DELAY_SECS 5
+#define RX_WINDOW_SYMBOLS 8
+/* a receive window that opens later than this into the preamble of a downlink misses it */
+#define RX_LATE_SYMBOLS 4
+
+/* scheduler */
+
+typedef struct {
+  uint64_t dueTicks;
+  osjob_t *job;
+} scheduled_job_t;
+
+static std::vector<osjob_t *> runnableJobs;
+static std::vector<scheduled_job_t> scheduledJobs;
+
+/* ostime_t wraps after about 9.5 hours, so compare it like LMIC does */
+static int32_t ticksBetween(ostime_t from, ostime_t to) {
+  return static_cast<int32_t>(static_cast<uint32_t>(to) - static_cast<uint32_t>(from));
+}
+
+static uint64_t nowTicks() {
+  return sim::nowUs() / US_PER_OSTICK;
+}
+
+static uint64_t absoluteTicks(ostime_t time) {
+  uint64_t now = nowTicks();
+  int32_t delta = ticksBetween(static_cast<ostime_t>(now), time);
+  return delta < 0 ? now : now + delta;
+}
+
+static void unlinkJob(osjob_t *job) {
+  for (size_t i = 0; i < runnableJobs.size(); i++) {
+    if (runnableJobs[i] == job) {
+      runnableJobs.erase(runnableJobs.begin() + i);
+      break;
+    }
+  }
+  for (size_t i = 0; i < scheduledJobs.size(); i++) {
+    if (scheduledJobs[i].job == job) {
+      scheduledJobs.erase(scheduledJobs.begin() + i);
+      break;
+    }
+  }
+}
+
+void os_init() {
+  runnableJobs.clear();
+  scheduledJobs.clear();
+  memset(&LMIC, 0, sizeof(LMIC));
+}
+
+int os_init_ex(const void *pPinMap) {
+  (void) (pPinMap);
+  os_init();
+  return 1;
+}
+
+ostime_t os_getTime() {
+  return static_cast<ostime_t>(nowTicks());
+}
+
+void os_setCallback(osjob_t *job, osjobcb_t cb) {
+  unlinkJob(job);
+  job->func = cb;
+  job->next = NULL;
+  runnableJobs.push_back(job);
+}
+
+void os_setTimedCallback(osjob_t *job, ostime_t time, osjobcb_t cb) {
+  unlinkJob(job);
+  job->func = cb;
+  job->deadline = time;
+  job->next = NULL;
+
+  scheduled_job_t entry = { absoluteTicks(time), job };
+  size_t i = 0;
+  while (i < scheduledJobs.size() && scheduledJobs[i].dueTicks <= entry.dueTicks) i++;
+  scheduledJobs.insert(scheduledJobs.begin() + i, entry);
+}
+
+void os_clearCallback(osjob_t *job) {
+  unlinkJob(job);
+}
+
+static void onTxDone(osjob_t *job);
+
+/*
+ * The first job that LMIC knows of. The end of an uplink is an edge of the
+ * radio's DIO0 line, which the simulation schedules like a job.
+ */
+static const scheduled_job_t *firstScheduledJob() {
+  for (size_t i = 0; i < scheduledJobs.size(); i++) {
+    if (scheduledJobs[i].job->func != onTxDone) return &scheduledJobs[i];
+  }
+  return NULL;
+}
+
+bit_t os_queryTimeCriticalJobs(ostime_t time) {
+  const scheduled_job_t *first = firstScheduledJob();
+  if (first != NULL) {
+    uint64_t horizon = nowTicks() + static_cast<uint64_t>(time);
+    if (first->dueTicks < horizon) return 1;
+  }
+  return 0;
+}
+
+ostime_t os_getNextDeadline(bit_t *pfDeadlineValid) {
+  // like LMIC, this only looks at the scheduled jobs
+  const scheduled_job_t *first = firstScheduledJob();
+  if (first == NULL) {
+    *pfDeadlineValid = 0;
+    return os_getTime();
+  }
+  *pfDeadlineValid = 1;
+  return first->job->deadline;
+}
+
+static void runJob(osjob_t *job) {
+  sim::counters().jobs += 1;
+  job->func(job);
+}
+
+namespace sim {
+
+/**
+ * Returns the virtual time of the next pending job or UINT64_MAX if there is none.
+ */
+uint64_t nextJobUs() {
+  if (!runnableJobs.empty()) return nowUs();
+  if (scheduledJobs.empty()) return UINT64_MAX;
+  return scheduledJobs.front().dueTicks * US_PER_OSTICK;
+}
+
+}
+
+void os_runloop_once() {
+  if (!runnableJobs.empty()) {
+    osjob_t *job = runnableJobs.front();
+    runnableJobs.erase(runnableJobs.begin());
+    runJob(job);
+    return;
+  }
+
+  if (scheduledJobs.empty()) return;
+
+  // a nap in standby ends a little before the deadline, the runloop spins for the rest
+  static uint64_t asleepUsAtLastWakeup;
+  bool napped = sim::counters().asleepUs != asleepUsAtLastWakeup;
+  uint64_t dueUs = scheduledJobs.front().dueTicks * US_PER_OSTICK;
+  if (dueUs > sim::nowUs()) {
+    // the real runloop would spin until the deadline is reached
+    if (!sim::idleUntil(dueUs)) return;
+    napped = true;
+  }
+  if (napped) {
+    sim::counters().wakeups += 1;
+    asleepUsAtLastWakeup = sim::counters().asleepUs;
+  }
+
+  osjob_t *job = scheduledJobs.front().job;
+  scheduledJobs.erase(scheduledJobs.begin());
+  runJob(job);
+}
+
+/* radio and MAC */
+
+static osjob_t engineJob;
+static sim::options_t macOptions;
+
+/* DeviceTimeReq, sent with the next uplink and answered in its receive windows */
+#define DEVICE_TIME_REQ_SIZE 1
+static lmic_request_network_time_cb_t *networkTimeCallback;
+static void *networkTimeUserData;
+static bool networkTimeRequestSent;
+static lmic_time_reference_t networkTimeReference;
+static bool networkTimeKnown;
+
+namespace sim {
+
+void configureMac(const options_t &options) {
+  macOptions = options;
+}
+
+}
+
+static uint8_t bandOfChannel(uint8_t channel) {
+  return LMIC.channelFreq[channel] & 0x3;
+}
+
+static bool channelSupportsDatarate(uint8_t channel, uint8_t datarate) {
+  return (LMIC.channelMap & (1 << channel)) && (LMIC.channelDrMap[channel] & (1 << datarate));
+}
+
+static void openRx1(osjob_t *job);
+static void openRx2(osjob_t *job);
+static void startTx(osjob_t *job);
+
+/*
+ * The radio raises DIO0 at the end of an uplink. With LMIC_USE_INTERRUPTS,
+ * the ISR stamps the edge right away. Otherwise, LMIC only notices it when
+ * the runloop polls the DIO lines, after the job that runs at the time, and
+ * the receive windows, which LMIC times from the stamp, open late.
+ */
+static uint64_t txDoneUs;
+
+// the longest off-time of a band, after a maximum size uplink at SF12 in a 0.1 % band
+#define BAND_MAX_OFF_TICKS sec2osticks(3 * 3600)
+
+static void scheduleTx() {
+  if (LMIC.opmode & (OP_TXRXPEND | OP_JOINING)) return;
+  if (!(LMIC.opmode & OP_TXDATA)) return;
+
+  ostime_t now = os_getTime();
+  ostime_t txbeg = 0;
+  bool found = false;
+  for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+    if (!channelSupportsDatarate(channel, LMIC.datarate)) continue;
+    ostime_t avail = LMIC.bands[bandOfChannel(channel)].avail;
+    // after hours without uplinks, a stale availability time wraps around into the future
+    if (ticksBetween(now, avail) > BAND_MAX_OFF_TICKS) avail = LMIC.bands[bandOfChannel(channel)].avail = now;
+    if (!found || ticksBetween(txbeg, avail) < 0) txbeg = avail;
+    found = true;
+  }
+  if (!found) return;
+  if (ticksBetween(now, txbeg) < 0) txbeg = now;
+  os_setTimedCallback(&engineJob, txbeg, startTx);
+}
+
+static void startTx(osjob_t *job) {
+  (void) (job);
+
+  ostime_t now = os_getTime();
+  uint8_t candidates[MAX_CHANNELS];
+  uint8_t nrofCandidates = 0;
+  for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+    if (!channelSupportsDatarate(channel, LMIC.datarate)) continue;
+    if (ticksBetween(now, LMIC.bands[bandOfChannel(channel)].avail) > 0) continue;
+    candidates[nrofCandidates++] = channel;
+  }
+  if (nrofCandidates == 0) {
+    scheduleTx();
+    return;
+  }
+
+  LMIC.txChnl = candidates[sim::random(nrofCandidates)];
+  networkTimeRequestSent = networkTimeCallback != NULL;
+  uint32_t airtime = airtimeOfUplinkUs(LMIC.datarate, LMIC.pendTxLen + (networkTimeRequestSent ? DEVICE_TIME_REQ_SIZE : 0));
+  band_t *band = &LMIC.bands[bandOfChannel(LMIC.txChnl)];
+  band->avail = now + us2osticks(static_cast<uint64_t>(airtime) * band->txcap);
+  band->lastchnl = LMIC.txChnl;
+
+  LMIC.opmode = (LMIC.opmode & ~OP_TXDATA) | OP_TXRXPEND;
+  LMIC.seqnoUp += 1;
+  txDoneUs = sim::nowUs() + airtime;
+  os_setTimedCallback(&engineJob, static_cast<ostime_t>(txDoneUs / US_PER_OSTICK), onTxDone);
+
+  sim::recordUplink(LMIC.datarate, LMIC.txChnl, LMIC.pendTxData, LMIC.pendTxLen, airtime);
+
+  // LMIC reports the event once the radio is on air
+  onEvent(EV_TXSTART);
+}
+
+static void onTxDone(osjob_t *job) {
+  (void) (job);
+  LMIC.txend = macOptions.pollRadio ? os_getTime() : static_cast<ostime_t>(txDoneUs / US_PER_OSTICK);
+  // RX1 opens one second after the end of the uplink
+  os_setTimedCallback(&engineJob, LMIC.txend + sec2osticks(1), openRx1);
+}
+
+/*
+ * Returns whether a receive window opening now catches a downlink that the
+ * network starts sending at downlinkUs.
+ */
+static bool rxWindowInTime(uint64_t downlinkUs, uint8_t datarate) {
+  uint64_t lateUs = RX_LATE_SYMBOLS * airtimeSymbolUs(airtimeParametersOfDatarate(datarate));
+  if (sim::nowUs() <= downlinkUs + lateUs) return true;
+  sim::counters().missedRxWindows += 1;
+  return false;
+}
+
+static ostime_t rxWindowTicks(uint8_t datarate) {
+  return us2osticks(airtimeSymbolUs(airtimeParametersOfDatarate(datarate)) * RX_WINDOW_SYMBOLS);
+}
+
+static void openRx1(osjob_t *job) {
+  (void) (job);
+  rxWindowInTime(txDoneUs + SIM_SECONDS(1), LMIC.datarate);
+  // there never is a downlink in RX1, RX2 opens one second later
+  onEvent(EV_RXSTART);
+  os_setTimedCallback(&engineJob, LMIC.txend + sec2osticks(2), openRx2);
+}
+
+static void openRx2(osjob_t *job) {
+  (void) (job);
+  bool inTime = rxWindowInTime(txDoneUs + SIM_SECONDS(2), LMIC.dn2Dr);
+  onEvent(EV_RXSTART);
+  // the radio listens for a preamble before it gives up on the downlink
+  sim::advanceUs(osticks2us(rxWindowTicks(LMIC.dn2Dr)));
+
+  LMIC.opmode &= ~OP_TXRXPEND;
+  LMIC.txrxFlags = 0;
+  LMIC.dataLen = 0;
+  LMIC.dataBeg = 0;
+
+  if (macOptions.adrWalk && sim::random(8) == 0) {
+    // the network server moves us one step up or down the datarate ladder
+    int datarate = LMIC.datarate + (sim::random(2) == 0 ? -1 : 1);
+    if (datarate >= DR_SF12 && datarate <= DR_SF7) LMIC.datarate = datarate;
+  }
+
+  if (networkTimeRequestSent) {
+    // the DeviceTimeAns refers to the end of the uplink; LMIC folds the fraction of the second into its stamp of it
+    uint64_t gpsUs = sim::gpsTimeUs(txDoneUs);
+    if (inTime) {
+      networkTimeReference.tNetwork = gpsUs / 1000000;
+      networkTimeReference.tLocal = LMIC.txend - us2osticks(gpsUs % 1000000);
+      networkTimeKnown = true;
+    }
+    networkTimeRequestSent = false;
+    lmic_request_network_time_cb_t *callback = networkTimeCallback;
+    networkTimeCallback = NULL;
+    callback(networkTimeUserData, inTime ? 1 : 0);
+  }
+
+  onEvent(EV_TXCOMPLETE);
+  scheduleTx();
+}
+
+static void completeJoin(osjob_t *job) {
+  (void) (job);
+  LMIC.opmode &= ~(OP_JOINING | OP_TXRXPEND);
+  LMIC.netid = 0x13;
+  LMIC.devaddr = 0x26000000 | sim::random(0x10000);
+  LMIC.seqnoUp = 0;
+  LMIC.seqnoDn = 0;
+  onEvent(EV_JOINED);
+  scheduleTx();
+}
+
+static void sendJoinRequest(osjob_t *job) {
+  (void) (job);
+  uint32_t airtime = airtimeUs(airtimeParametersOfDatarate(LMIC.datarate), JOIN_REQUEST_SIZE);
+  LMIC.txChnl = sim::random(3);
+  LMIC.txend = os_getTime() + us2osticks(airtime);
+  LMIC.devNonce += 1;
+  sim::recordJoinRequest(LMIC.datarate, airtime);
+  onEvent(EV_TXSTART);
+  os_setTimedCallback(&engineJob, LMIC.txend + sec2osticks(JOIN_ACCEPT_DELAY_SECS), completeJoin);
+}
+
+void LMIC_reset() {
+  os_clearCallback(&engineJob);
+  memset(&LMIC, 0, sizeof(LMIC));
+  networkTimeCallback = NULL;
+  networkTimeRequestSent = false;
+  networkTimeKnown = false;
+  LMIC.datarate = DR_SF12;
+  LMIC.adrTxPow = 14;
+  LMIC.txpow = 14;
+  LMIC.dn2Dr = DR_SF12;
+  LMIC.rxDelay = 1;
+  LMIC.bands[BAND_MILLI].txcap = 1000;
+  LMIC.bands[BAND_CENTI].txcap = 100;
+  LMIC.bands[BAND_DECI].txcap = 10;
+  LMIC.bands[BAND_AUX].txcap = 1;
+
+  // the three default EU868 join channels
+  LMIC_setupChannel(0, 868100000, DR_RANGE_MAP(DR_SF12, DR_SF7), BAND_CENTI);
+  LMIC_setupChannel(1, 868300000, DR_RANGE_MAP(DR_SF12, DR_SF7B), BAND_CENTI);
+  LMIC_setupChannel(2, 868500000, DR_RANGE_MAP(DR_SF12, DR_SF7), BAND_CENTI);
+
+  if (macOptions.datarate >= 0) LMIC.datarate = macOptions.datarate;
+}
+
+void LMIC_setSession(u4_t netid, devaddr_t devaddr, xref2u1_t nwkKey, xref2u1_t artKey) {
+  LMIC.netid = netid;
+  LMIC.devaddr = devaddr;
+  if (nwkKey != NULL) memcpy(LMIC.nwkKey, nwkKey, sizeof(LMIC.nwkKey));
+  if (artKey != NULL) memcpy(LMIC.artKey, artKey, sizeof(LMIC.artKey));
+  LMIC.opmode &= ~(OP_JOINING | OP_REJOIN);
+}
+
+bit_t LMIC_setupChannel(u1_t channel, u4_t freq, u2_t drmap, s1_t band) {
+  if (channel >= MAX_CHANNELS) return 0;
+  if (band < 0) band = BAND_CENTI;
+  LMIC.channelFreq[channel] = (freq & ~3u) | band;
+  LMIC.channelDrMap[channel] = drmap;
+  LMIC.channelMap |= 1 << channel;
+  return 1;
+}
+
+void LMIC_setDrTxpow(dr_t dr, s1_t txpow) {
+  LMIC.datarate = macOptions.datarate >= 0 ? macOptions.datarate : dr;
+  LMIC.adrTxPow = txpow;
+}
+
+void LMIC_setAdrMode(bit_t enabled) {
+  LMIC.adrEnabled = enabled;
+}
+
+bit_t LMIC_startJoining() {
+  if (LMIC.devaddr != 0 || (LMIC.opmode & OP_JOINING)) return 0;
+  LMIC.opmode |= OP_JOINING;
+  onEvent(EV_JOINING);
+  os_setCallback(&engineJob, sendJoinRequest);
+  return 1;
+}
+
+lmic_tx_error_t LMIC_setTxData2_strict(u1_t port, xref2u1_t data, u1_t dlen, u1_t confirmed) {
+  if (LMIC.opmode & OP_TXDATA) return LMIC_ERROR_TX_BUSY;
+  return LMIC_setTxData2(port, data, dlen, confirmed);
+}
+
+lmic_tx_error_t LMIC_setTxData2(u1_t port, xref2u1_t data, u1_t dlen, u1_t confirmed) {
+  if (dlen > MAX_LEN_PAYLOAD) return LMIC_ERROR_TX_TOO_LARGE;
+  if (sim::nowUs() >= SIM_SECONDS(macOptions.outageStartSecs)
+      && sim::nowUs() < SIM_SECONDS(macOptions.outageStartSecs + macOptions.outageSecs)) return LMIC_ERROR_TX_FAILED;
+
+  // like the real stack, a frame that has not been sent yet is overwritten
+  if (data != NULL) memcpy(LMIC.pendTxData, data, dlen);
+  LMIC.pendTxPort = port;
+  LMIC.pendTxConf = confirmed;
+  LMIC.pendTxLen = dlen;
+  LMIC.opmode |= OP_TXDATA;
+  sim::recordQueued();
+
+  scheduleTx();
+  return LMIC_ERROR_SUCCESS;
+}
+
+void LMIC_clrTxData() {
+  LMIC.opmode &= ~(OP_TXDATA | OP_POLL);
+  LMIC.pendTxLen = 0;
+  if (!(LMIC.opmode & (OP_TXRXPEND | OP_JOINING))) os_clearCallback(&engineJob);
+}
+
+void LMIC_setSeqnoUp(u4_t seqno) {
+  LMIC.seqnoUp = seqno;
+}
+
+void LMIC_getSessionKeys(u4_t *netid, devaddr_t *devaddr, xref2u1_t nwkKey, xref2u1_t artKey) {
+  *netid = LMIC.netid;
+  *devaddr = LMIC.devaddr;
+  memcpy(nwkKey, LMIC.nwkKey, sizeof(LMIC.nwkKey));
+  memcpy(artKey, LMIC.artKey, sizeof(LMIC.artKey));
+}
+
+void LMIC_requestNetworkTime(lmic_request_network_time_cb_t *pCallbackfn, void *pUserData) {
+  networkTimeCallback = pCallbackfn;
+  networkTimeUserData = pUserData;
+}
+
+int LMIC_getNetworkTimeReference(lmic_time_reference_t *pReference) {
+  if (pReference == NULL || !networkTimeKnown) return 0;
+  *pReference = networkTimeReference;
+  return 1;
+}
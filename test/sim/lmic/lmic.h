@@ -0,0 +1,200 @@
+#ifndef LMIC_LMIC_H
+#define LMIC_LMIC_H
+
+/*
+ * Host stand-in for the subset of the MCCI LoRaWAN LMIC API used by Clairchen.
+ *
+ * Names, types and semantics follow arduino-lmic 3.x for the EU868 band plan.
+ * The radio is not modelled bit by bit: an uplink occupies its LoRa airtime,
+ * is followed by the two receive windows, and completes with EV_TXCOMPLETE.
+ * Per-band duty cycle limits are enforced like the real stack does.
+ */
+
+#include <stdint.h>
+
+typedef uint8_t bit_t;
+typedef uint8_t u1_t;
+typedef int8_t s1_t;
+typedef uint16_t u2_t;
+typedef int16_t s2_t;
+typedef uint32_t u4_t;
+typedef int32_t s4_t;
+typedef int64_t s8_t;
+typedef unsigned int uint;
+typedef const char *str_t;
+
+typedef u1_t *xref2u1_t;
+typedef const u1_t *xref2cu1_t;
+
+typedef s4_t ostime_t;
+typedef u4_t devaddr_t;
+typedef u1_t dr_t;
+
+#define OSTICKS_PER_SEC 62500
+#define us2osticks(us) ((ostime_t) (((s8_t) (us) * OSTICKS_PER_SEC) / 1000000))
+#define ms2osticks(ms) ((ostime_t) (((s8_t) (ms) * OSTICKS_PER_SEC) / 1000))
+#define sec2osticks(sec) ((ostime_t) ((s8_t) (sec) * OSTICKS_PER_SEC))
+#define osticks2ms(os) ((s4_t) (((os) * (s8_t) 1000) / OSTICKS_PER_SEC))
+#define osticks2us(os) ((s4_t) (((os) * (s8_t) 1000000) / OSTICKS_PER_SEC))
+#define us2osticksRound(us) ((ostime_t) (((s8_t) (us) * OSTICKS_PER_SEC + 500000) / 1000000))
+#define ms2osticksRound(ms) ((ostime_t) (((s8_t) (ms) * OSTICKS_PER_SEC + 500) / 1000))
+
+struct osjob_t;
+typedef void (*osjobcb_t)(struct osjob_t *);
+struct osjob_t {
+  struct osjob_t *next;
+  ostime_t deadline;
+  osjobcb_t func;
+};
+typedef struct osjob_t osjob_t;
+
+void os_init();
+int os_init_ex(const void *pPinMap);
+ostime_t os_getTime();
+void os_setCallback(osjob_t *job, osjobcb_t cb);
+void os_setTimedCallback(osjob_t *job, ostime_t time, osjobcb_t cb);
+void os_clearCallback(osjob_t *job);
+void os_runloop_once();
+bit_t os_queryTimeCriticalJobs(ostime_t time);
+ostime_t os_getNextDeadline(bit_t *pfDeadlineValid);
+
+/* data rates, in the order of lorabase_eu868.h */
+enum _dr_eu868_t { DR_SF12 = 0, DR_SF11, DR_SF10, DR_SF9, DR_SF8, DR_SF7, DR_SF7B, DR_FSK, DR_NONE };
+
+#define DR_RANGE_MAP(drlo, drhi) ((u2_t) ((((u2_t) ~0) << (drlo)) & ~(((u2_t) ~0) << ((drhi) + 1))))
+
+enum { BAND_MILLI = 0, BAND_CENTI = 1, BAND_DECI = 2, BAND_AUX = 3 };
+enum { MAX_BANDS = 4, MAX_CHANNELS = 16 };
+enum { MAX_LEN_FRAME = 64, MAX_LEN_PAYLOAD = 51 };
+
+typedef struct {
+  u2_t txcap;     // duty cycle limitation: 1 / txcap
+  s1_t txpow;
+  u1_t lastchnl;
+  ostime_t avail; // channel is blocked until this time
+} band_t;
+
+enum {
+  OP_NONE = 0x0000,
+  OP_SCAN = 0x0001,
+  OP_TRACK = 0x0002,
+  OP_JOINING = 0x0004,
+  OP_TXDATA = 0x0008,
+  OP_POLL = 0x0010,
+  OP_REJOIN = 0x0020,
+  OP_SHUTDOWN = 0x0040,
+  OP_TXRXPEND = 0x0080,
+  OP_RNDTX = 0x0100,
+  OP_PINGINI = 0x0200,
+  OP_PINGABLE = 0x0400,
+  OP_NEXTCHNL = 0x0800,
+  OP_LINKDEAD = 0x1000,
+  OP_TESTMODE = 0x2000,
+  OP_UNJOIN = 0x4000
+};
+
+enum {
+  TXRX_ACK = 0x80,
+  TXRX_NACK = 0x40,
+  TXRX_NOPORT = 0x20,
+  TXRX_PORT = 0x10,
+  TXRX_LENERR = 0x08,
+  TXRX_PING = 0x04,
+  TXRX_DNW2 = 0x02,
+  TXRX_DNW1 = 0x01
+};
+
+enum _ev_t {
+  EV_SCAN_TIMEOUT = 1, EV_BEACON_FOUND,
+  EV_BEACON_MISSED, EV_BEACON_TRACKED, EV_JOINING,
+  EV_JOINED, EV_RFU1, EV_JOIN_FAILED, EV_REJOIN_FAILED,
+  EV_TXCOMPLETE, EV_LOST_TSYNC, EV_RESET,
+  EV_RXCOMPLETE, EV_LINK_DEAD, EV_LINK_ALIVE, EV_SCAN_FOUND,
+  EV_TXSTART, EV_TXCANCELED, EV_RXSTART, EV_JOIN_TXCOMPLETE
+};
+typedef enum _ev_t ev_t;
+
+typedef int lmic_tx_error_t;
+enum {
+  LMIC_ERROR_SUCCESS = 0,
+  LMIC_ERROR_TX_BUSY = -1,
+  LMIC_ERROR_TX_TOO_LARGE = -2,
+  LMIC_ERROR_TX_NOT_FEASIBLE = -3,
+  LMIC_ERROR_TX_FAILED = -4
+};
+
+struct lmic_t {
+  u1_t frame[MAX_LEN_FRAME];
+  u1_t dataLen;
+  u1_t dataBeg;
+  u1_t txrxFlags;
+  s2_t rssi;
+  s1_t snr;
+
+  u2_t opmode;
+  ostime_t txend;
+  u1_t txChnl;
+  dr_t datarate;
+  s1_t txpow;
+  s1_t adrTxPow;
+  bit_t adrEnabled;
+  s1_t adrAckReq;
+
+  u4_t netid;
+  devaddr_t devaddr;
+  u1_t nwkKey[16];
+  u1_t artKey[16];
+  u4_t seqnoUp;
+  u4_t seqnoDn;
+  u2_t devNonce;
+
+  dr_t dn2Dr;
+  u1_t dnConf;
+  u1_t rx1DrOffset;
+  u1_t rxDelay;
+
+  band_t bands[MAX_BANDS];
+  u4_t channelFreq[MAX_CHANNELS];
+  u4_t channelDlFreq[MAX_CHANNELS];
+  u2_t channelDrMap[MAX_CHANNELS];
+  u2_t channelMap;
+  ostime_t globalDutyAvail;
+  u1_t globalDutyRate;
+
+  u1_t pendTxPort;
+  u1_t pendTxConf;
+  u1_t pendTxLen;
+  u1_t pendTxData[MAX_LEN_PAYLOAD];
+};
+
+extern struct lmic_t LMIC;
+
+/* network time, LMIC_ENABLE_DeviceTimeReq */
+typedef u4_t lmic_gpstime_t;
+typedef struct lmic_time_reference_s {
+  ostime_t tLocal;          // local time at which the network time was valid
+  lmic_gpstime_t tNetwork;  // GPS seconds
+} lmic_time_reference_t;
+typedef void lmic_request_network_time_cb_t(void *pUserData, int flagSuccess);
+
+void LMIC_reset();
+void LMIC_setSession(u4_t netid, devaddr_t devaddr, xref2u1_t nwkKey, xref2u1_t artKey);
+bit_t LMIC_setupChannel(u1_t channel, u4_t freq, u2_t drmap, s1_t band);
+void LMIC_setDrTxpow(dr_t dr, s1_t txpow);
+void LMIC_setAdrMode(bit_t enabled);
+bit_t LMIC_startJoining();
+lmic_tx_error_t LMIC_setTxData2(u1_t port, xref2u1_t data, u1_t dlen, u1_t confirmed);
+lmic_tx_error_t LMIC_setTxData2_strict(u1_t port, xref2u1_t data, u1_t dlen, u1_t confirmed);
+void LMIC_clrTxData();
+void LMIC_setSeqnoUp(u4_t seqno);
+void LMIC_getSessionKeys(u4_t *netid, devaddr_t *devaddr, xref2u1_t nwkKey, xref2u1_t artKey);
+void LMIC_requestNetworkTime(lmic_request_network_time_cb_t *pCallbackfn, void *pUserData);
+int LMIC_getNetworkTimeReference(lmic_time_reference_t *pReference);
+
+/* application callbacks */
+void onEvent(ev_t ev);
+void os_getArtEui(u1_t *buf);
+void os_getDevEui(u1_t *buf);
+void os_getDevKey(u1_t *buf);
+
+#endif /* LMIC_LMIC_H */
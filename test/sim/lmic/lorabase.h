@@ -0,0 +1,6 @@
+#ifndef LMIC_LORABASE_H
+#define LMIC_LORABASE_H
+
+#include "lmic.h"
+
+#endif /* LMIC_LORABASE_H */
@@ -0,0 +1,91 @@
+/*
+ * Runs the Clairchen firmware in virtual time and reports what it costs
+ * and what it delivers.
+ *
+ * Usage: clairchen-sim [--days N] [--datarate DR] [--adr-walk] [--outage START_H HOURS] [--seed N] [--poll-radio] [--verbose]
+ */
+
+#include "sim.h"
+#include "airtime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *program) {
+  fprintf(stderr, "usage: %s [--days N] [--datarate DR] [--adr-walk] [--outage START_H HOURS] [--seed N] [--poll-radio] [--verbose]\n",
+      program);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  sim::options_t options;
+  options.datarate = -1;
+  options.adrWalk = false;
+  options.seed = 1;
+  options.verbose = false;
+  options.devEui = 0;
+  options.pollRadio = false;
+  options.outageStartSecs = 0;
+  options.outageSecs = 0;
+  unsigned days = 7;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+      days = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--datarate") == 0 && i + 1 < argc) {
+      options.datarate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--adr-walk") == 0) {
+      options.adrWalk = true;
+    } else if (strcmp(argv[i], "--outage") == 0 && i + 2 < argc) {
+      options.outageStartSecs = atoi(argv[++i]) * 3600;
+      options.outageSecs = atoi(argv[++i]) * 3600;
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      options.seed = strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--poll-radio") == 0) {
+      options.pollRadio = true;
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      options.verbose = true;
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (days == 0) usage(argv[0]);
+
+  sim::configure(options);
+  sim::runUntil(SIM_DAYS(days));
+
+  const std::vector<sim::uplink_t> &uplinks = sim::uplinks();
+  uint64_t totalAirtimeUs = 0;
+  uint64_t maxQueuingDelayUs = 0;
+  for (size_t i = 0; i < uplinks.size(); i++) {
+    totalAirtimeUs += uplinks[i].airtimeUs;
+    if (uplinks[i].timeUs - uplinks[i].queuedUs > maxQueuingDelayUs) maxQueuingDelayUs = uplinks[i].timeUs - uplinks[i].queuedUs;
+  }
+  uint64_t maxDailyAirtimeUs = sim::maxAirtimeInWindowUs(SIM_DAYS(1));
+  uint64_t samples = sim::transmittedSamples();
+  const sim::counters_t &counters = sim::counters();
+
+  printf("simulated days:             %u\n", days);
+  printf("uplinks:                    %zu (%.1f per day)\n", uplinks.size(), uplinks.size() / (double) days);
+  printf("airtime total [s]:          %.3f\n", totalAirtimeUs / 1e6);
+  printf("airtime max per 24 h [s]:   %.3f (budget %.0f s)%s\n", maxDailyAirtimeUs / 1e6,
+      AIRTIME_TTN_BUDGET_US_PER_DAY / 1e6, maxDailyAirtimeUs > AIRTIME_TTN_BUDGET_US_PER_DAY ? " EXCEEDED" : "");
+  printf("max LMIC queuing delay [s]: %.3f\n", maxQueuingDelayUs / 1e6);
+  printf("transmitted samples:        %llu (%.1f per day)\n", (unsigned long long) samples, samples / (double) days);
+  printf("backfilled samples:         %llu\n", (unsigned long long) sim::backfilledSamples());
+  printf("samples on UTC grid:        %llu of %llu\n", (unsigned long long) sim::alignedSamples(),
+      (unsigned long long) sim::sampleListSamples());
+  printf("covered sampling periods:   %llu (%.1f per day)\n", (unsigned long long) sim::coveredSamplingPeriods(),
+      sim::coveredSamplingPeriods() / (double) days);
+  printf("sensor reads:               %llu (%.1f per transmitted sample)\n", (unsigned long long) counters.sensorReads,
+      samples > 0 ? counters.sensorReads / (double) samples : 0.0);
+  printf("CPU wakeups:                %llu (%.1f per minute)\n", (unsigned long long) counters.wakeups,
+      counters.wakeups / (days * 24.0 * 60.0));
+  printf("CPU awake [%%]:              %.3f\n", 100.0 * (SIM_DAYS(days) - counters.asleepUs) / SIM_DAYS(days));
+  printf("missed receive windows:     %llu\n", (unsigned long long) counters.missedRxWindows);
+  printf("LMIC jobs:                  %llu\n", (unsigned long long) counters.jobs);
+  printf("LED toggles by the CPU:     %llu\n", (unsigned long long) counters.ledToggles);
+  printf("LED timer patterns:         %llu\n", (unsigned long long) counters.ledPatterns);
+
+  return maxDailyAirtimeUs > AIRTIME_TTN_BUDGET_US_PER_DAY ? 1 : 0;
+}
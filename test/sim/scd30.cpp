@@ -0,0 +1,122 @@
+#include "sim.h"
+#include <SparkFun_SCD30_Arduino_Library.h>
+#include <math.h>
+
+#define OUTDOOR_CO2_PPM 420.0
+#define CO2_PPM_PER_OCCUPANT 90.0
+#define OCCUPIED_TIME_CONSTANT_SECS (30 * 60.0)
+#define VENTILATED_TIME_CONSTANT_SECS (5 * 60.0)
+#define EMPTY_TIME_CONSTANT_SECS (90 * 60.0)
+#define MODEL_STEP_SECS 60
+
+/* the library waits 3 ms for the sensor to prepare its answer, then reads it at 100 kHz */
+#define I2C_STATUS_READ_US 3500
+#define I2C_MEASUREMENT_READ_US 5000
+
+/*
+ * A small office: eight people on weekdays from 8:00 to 12:00 and from 13:00
+ * to 17:00, with the windows opened for ten minutes at 10:00 and at 15:00.
+ * The simulation starts on a Monday at midnight.
+ */
+static int occupantsAt(uint64_t seconds) {
+  uint64_t day = seconds / (24 * 3600);
+  uint64_t minuteOfDay = (seconds % (24 * 3600)) / 60;
+  if (day % 7 >= 5) return 0;
+  if (minuteOfDay >= 8 * 60 && minuteOfDay < 12 * 60) return 8;
+  if (minuteOfDay >= 13 * 60 && minuteOfDay < 17 * 60) return 8;
+  return 0;
+}
+
+static bool windowsOpenAt(uint64_t seconds) {
+  uint64_t minuteOfDay = (seconds % (24 * 3600)) / 60;
+  return (minuteOfDay >= 10 * 60 && minuteOfDay < 10 * 60 + 10)
+      || (minuteOfDay >= 15 * 60 && minuteOfDay < 15 * 60 + 10);
+}
+
+static double roomCo2 = OUTDOOR_CO2_PPM;
+static uint64_t roomSeconds = 0;
+
+static void advanceRoomModel(uint64_t seconds) {
+  while (roomSeconds < seconds) {
+    uint64_t step = seconds - roomSeconds;
+    if (step > MODEL_STEP_SECS) step = MODEL_STEP_SECS;
+
+    int occupants = occupantsAt(roomSeconds);
+    double equilibrium = OUTDOOR_CO2_PPM + CO2_PPM_PER_OCCUPANT * occupants;
+    double timeConstant = occupants > 0 ? OCCUPIED_TIME_CONSTANT_SECS : EMPTY_TIME_CONSTANT_SECS;
+    if (windowsOpenAt(roomSeconds)) {
+      equilibrium = OUTDOOR_CO2_PPM;
+      timeConstant = VENTILATED_TIME_CONSTANT_SECS;
+    }
+    roomCo2 = equilibrium + (roomCo2 - equilibrium) * exp(-static_cast<double>(step) / timeConstant);
+    roomSeconds += step;
+  }
+}
+
+bool SCD30::begin(bool autoCalibrate) {
+  (void) (autoCalibrate);
+  return beginMeasuring();
+}
+
+bool SCD30::beginMeasuring() {
+  if (!measuring) measuringSinceUs = sim::nowUs();
+  measuring = true;
+  return true;
+}
+
+bool SCD30::StopMeasurement() {
+  measuring = false;
+  return true;
+}
+
+bool SCD30::setMeasurementInterval(uint16_t interval) {
+  intervalSecs = interval;
+  return true;
+}
+
+static uint64_t latestMeasurement(uint64_t measuringSinceUs, uint16_t intervalSecs) {
+  return (sim::nowUs() - measuringSinceUs) / SIM_SECONDS(intervalSecs);
+}
+
+bool SCD30::dataAvailable() {
+  sim::advanceUs(I2C_STATUS_READ_US);
+  if (!measuring) return false;
+  uint64_t latest = latestMeasurement(measuringSinceUs, intervalSecs);
+  return latest > 0 && sim::nowUs() - lastReadUs >= SIM_SECONDS(intervalSecs);
+}
+
+bool SCD30::readMeasurement() {
+  sim::advanceUs(I2C_MEASUREMENT_READ_US);
+  if (!measuring || latestMeasurement(measuringSinceUs, intervalSecs) == 0) return false;
+
+  uint64_t seconds = sim::nowUs() / 1000000;
+  advanceRoomModel(seconds);
+
+  double noise = static_cast<double>(sim::random(41)) - 20.0;
+  co2 = static_cast<uint16_t>(roomCo2 + noise + 0.5);
+  temperature = 20.5 + 0.002 * (roomCo2 - OUTDOOR_CO2_PPM) + 0.01 * (sim::random(21) - 10.0);
+  humidity = 38.0 + 0.008 * (roomCo2 - OUTDOOR_CO2_PPM) + 0.05 * (sim::random(21) - 10.0);
+
+  lastReadUs = sim::nowUs();
+  fresh[0] = fresh[1] = fresh[2] = true;
+  sim::onSensorRead();
+  return true;
+}
+
+uint16_t SCD30::getCO2() {
+  if (!fresh[0]) readMeasurement();
+  fresh[0] = false;
+  return co2;
+}
+
+float SCD30::getTemperature() {
+  if (!fresh[1]) readMeasurement();
+  fresh[1] = false;
+  return temperature;
+}
+
+float SCD30::getHumidity() {
+  if (!fresh[2]) readMeasurement();
+  fresh[2] = false;
+  return humidity;
+}
@@ -0,0 +1,212 @@
+#include "sim.h"
+#include "clair_protocol.h"
+#include "clairchen_config.h"
+#include "tools/clairchen_decoder.h"
+#include <lmic/lmic.h>
+#include <Arduino.h>
+#include "euis.h"
+#include <string.h>
+
+void setup();
+void loop();
+
+static uint64_t clockUs;
+static uint64_t stopUs;
+static uint64_t queuedUs;
+static bool setupDone;
+static uint32_t randomState = 1;
+static uint8_t nodeDevEui[8];
+static bool nodeDevEuiSet;
+static std::vector<sim::uplink_t> uplinkLog;
+static sim::counters_t simCounters;
+
+namespace sim {
+
+void configure(const options_t &options) {
+  randomState = options.seed != 0 ? options.seed : 1;
+  nodeDevEuiSet = options.devEui != 0;
+  for (int i = 0; i < 8; i++) {
+    nodeDevEui[i] = options.devEui >> (8 * i);
+  }
+  setSerialVerbose(options.verbose);
+  configureMac(options);
+}
+
+uint64_t nowUs() {
+  return clockUs;
+}
+
+void advanceUs(uint64_t us) {
+  clockUs += us;
+}
+
+// 2021-03-01 12:03:17.437 UTC
+#define GPS_TIME_AT_START_US 1298635415437000ULL
+
+uint64_t gpsTimeUs(uint64_t us) {
+  return GPS_TIME_AT_START_US + us;
+}
+
+const uint8_t *devEui() {
+  return nodeDevEuiSet ? nodeDevEui : BLACK_DEVEUI;
+}
+
+bool idleUntil(uint64_t us) {
+  if (us > stopUs) {
+    clockUs = stopUs;
+    return false;
+  }
+  clockUs = us;
+  return true;
+}
+
+void runUntil(uint64_t endUs) {
+  stopUs = endUs;
+  if (!setupDone) {
+    setupDone = true;
+    setup();
+  }
+  while (clockUs < endUs) {
+    loop();
+    if (nextJobUs() == UINT64_MAX) clockUs = endUs;
+  }
+}
+
+const std::vector<uplink_t> &uplinks() {
+  return uplinkLog;
+}
+
+counters_t &counters() {
+  return simCounters;
+}
+
+uint64_t maxAirtimeInWindowUs(uint64_t windowUs) {
+  uint64_t maximum = 0;
+  uint64_t sum = 0;
+  size_t first = 0;
+  for (size_t last = 0; last < uplinkLog.size(); last++) {
+    sum += uplinkLog[last].airtimeUs;
+    while (uplinkLog[last].timeUs - uplinkLog[first].timeUs >= windowUs) {
+      sum -= uplinkLog[first].airtimeUs;
+      first += 1;
+    }
+    if (sum > maximum) maximum = sum;
+  }
+  return maximum;
+}
+
+uint64_t transmittedSamples() {
+  uint64_t samples = 0;
+  for (size_t i = 0; i < uplinkLog.size(); i++) {
+    if (uplinkLog[i].length == 0) continue;
+    uint8_t header = uplinkLog[i].payload[0];
+    uint8_t messageId = (header >> 3) & 0x7;
+    // sample lists, plain (0) or delta encoded (1)
+    if (messageId == 0 || messageId == 1) samples += (header & 0x7) + 1;
+    // Rice-coded sample lists keep the number of samples after the first sample
+    if (messageId == 2 && uplinkLog[i].length > 4) samples += (uplinkLog[i].payload[4] >> 4) + 1;
+    // breakpoint lists (3)
+    if (messageId == 3) samples += (header & 0x7) + 1;
+  }
+  return samples + backfilledSamples();
+}
+
+uint64_t backfilledSamples() {
+  uint64_t samples = 0;
+  for (size_t i = 0; i < uplinkLog.size(); i++) {
+    // backfill lists (6) are Rice coded after a 2-byte age
+    uint8_t messageId = (uplinkLog[i].payload[0] >> 3) & 0x7;
+    if (messageId == 6 && uplinkLog[i].length > 6) samples += (uplinkLog[i].payload[6] >> 4) + 1;
+  }
+  return samples;
+}
+
+static uint64_t countSampleListSamples(bool aligned) {
+  uint64_t samples = 0;
+  for (size_t i = 0; i < uplinkLog.size(); i++) {
+    decoded_message_t message;
+    if (uplinkLog[i].length == 0 || !decodeClairchenMessage(uplinkLog[i].payload, uplinkLog[i].length, &message)) continue;
+    if (message.messageId > CLAIR_MESSAGE_ID_RICE_LIST || message.samplingPeriodSeconds == 0) continue;
+    if (!aligned) {
+      samples += message.numberOfSamples;
+      continue;
+    }
+    // the age is told in whole seconds
+    uint64_t endUs = gpsTimeUs(uplinkLog[i].timeUs) - SIM_SECONDS(ClairchenConfig::GPS_UTC_OFFSET_SECS)
+        - SIM_SECONDS(message.transmissionDelaySeconds);
+    uint64_t periodUs = SIM_SECONDS(message.samplingPeriodSeconds);
+    uint64_t offsetUs = endUs % periodUs;
+    if (offsetUs < SIM_SECONDS(2) || periodUs - offsetUs < SIM_SECONDS(2)) samples += message.numberOfSamples;
+  }
+  return samples;
+}
+
+uint64_t sampleListSamples() {
+  return countSampleListSamples(false);
+}
+
+uint64_t alignedSamples() {
+  return countSampleListSamples(true);
+}
+
+uint64_t coveredSamplingPeriods() {
+  uint64_t periods = 0;
+  uint64_t previousUs = 0;
+  for (size_t i = 0; i < uplinkLog.size(); i++) {
+    if (uplinkLog[i].length < 2) continue;
+    uint8_t messageId = (uplinkLog[i].payload[0] >> 3) & 0x7;
+    // sample lists (0 - 2) and heartbeats (5) carry the sampling period in units of 5 s
+    if (messageId > 2 && messageId != 5) continue;
+    uint64_t periodUs = SIM_SECONDS(uplinkLog[i].payload[1] * 5);
+    if (periodUs == 0) continue;
+    periods += (uplinkLog[i].queuedUs - previousUs + periodUs / 2) / periodUs;
+    previousUs = uplinkLog[i].queuedUs;
+  }
+  return periods;
+}
+
+void recordQueued() {
+  queuedUs = clockUs;
+}
+
+void recordUplink(uint8_t datarate, uint8_t channel, const uint8_t *payload, uint8_t length, uint32_t airtimeUs) {
+  uplink_t uplink;
+  uplink.timeUs = clockUs;
+  uplink.queuedUs = queuedUs;
+  uplink.airtimeUs = airtimeUs;
+  uplink.datarate = datarate;
+  uplink.channel = channel;
+  uplink.length = length;
+  memcpy(uplink.payload, payload, length);
+  uplinkLog.push_back(uplink);
+}
+
+void recordJoinRequest(uint8_t datarate, uint32_t airtimeUs) {
+  uplink_t uplink;
+  uplink.timeUs = clockUs;
+  uplink.queuedUs = clockUs;
+  uplink.airtimeUs = airtimeUs;
+  uplink.datarate = datarate;
+  uplink.channel = LMIC.txChnl;
+  uplink.length = 0;
+  uplinkLog.push_back(uplink);
+}
+
+void onSensorRead() {
+  simCounters.sensorReads += 1;
+}
+
+void onLedWrite(int value) {
+  (void) (value);
+  simCounters.ledToggles += 1;
+}
+
+uint32_t random(uint32_t bound) {
+  // xorshift32
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return bound == 0 ? 0 : randomState % bound;
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Virtual-time stand-in for the Feather M0, the SCD30 and the LMIC runtime.
+ *
+ * The firmware sources are compiled unchanged against the headers in this
+ * directory. Time only advances when the firmware waits: os_runloop_once()
+ * jumps straight to the next scheduled job and delay() moves the clock
+ * forward, so a simulated week runs in a few seconds.
+ */
+namespace sim {
+
+typedef struct {
+  uint64_t timeUs;        // virtual time at which the radio started transmitting
+  uint64_t queuedUs;      // virtual time at which the frame was handed to LMIC
+  uint32_t airtimeUs;
+  uint8_t datarate;
+  uint8_t channel;
+  uint8_t length;         // application payload length in bytes
+  uint8_t payload[51];
+} uplink_t;
+
+typedef struct {
+  uint64_t wakeups;       // number of distinct instants the CPU left idle
+  uint64_t jobs;          // number of LMIC jobs executed
+  uint64_t sensorReads;   // number of SCD30 measurements fetched
+  uint64_t ledToggles;    // number of LED_BUILTIN level changes by digitalWrite()
+  uint64_t ledPatterns;   // number of blink patterns handed to the LED timer
+  uint64_t asleepUs;      // virtual time the CPU spent in standby
+  uint64_t missedRxWindows; // receive windows that opened too late for a downlink
+} counters_t;
+
+typedef struct {
+  int datarate;           // pin the datarate to this DR, or -1 to follow the firmware
+  bool adrWalk;           // let the "network server" move the datarate around
+  uint32_t seed;          // seed of the pseudo-random generators
+  bool verbose;           // forward Serial output to stdout
+  uint32_t outageStartSecs; // LMIC refuses uplinks from this time on,
+  uint32_t outageSecs;      // for this long, like a node that has not joined yet
+  uint64_t devEui;        // DevEUI of the node, or 0 for the one of Mr. Black
+  bool pollRadio;         // like LMIC without LMIC_USE_INTERRUPTS, see the project config
+} options_t;
+
+void configure(const options_t &options);
+
+uint64_t nowUs();
+void advanceUs(uint64_t us);
+
+/**
+ * GPS time of the virtual clock, as told by the network, in microseconds.
+ * The simulation starts at an odd instant, so that nodes have to align.
+ */
+uint64_t gpsTimeUs(uint64_t us);
+
+/**
+ * DevEUI of the simulated node, least-significant byte first
+ */
+const uint8_t *devEui();
+
+/**
+ * Runs LMIC jobs until the virtual clock reaches endUs.
+ * Calls the sketch's setup() first if it has not run yet.
+ */
+void runUntil(uint64_t endUs);
+
+const std::vector<uplink_t> &uplinks();
+counters_t &counters();
+
+/**
+ * Largest uplink airtime within any window of windowUs, in microseconds.
+ */
+uint64_t maxAirtimeInWindowUs(uint64_t windowUs);
+
+/**
+ * Number of samples carried by all uplinks, as announced by their headers.
+ */
+uint64_t transmittedSamples();
+
+/**
+ * Number of samples carried by backfill lists, included in transmittedSamples()
+ */
+uint64_t backfilledSamples();
+
+/**
+ * Number of samples of sample lists, excluding backfill and breakpoint lists,
+ * and how many of them end on a multiple of their sampling period in UTC,
+ * within a second, as told by the age of the last sample.
+ */
+uint64_t sampleListSamples();
+uint64_t alignedSamples();
+
+/**
+ * Number of sampling periods covered by sample lists and heartbeats, which
+ * includes the unchanged samples that the node did not send.
+ */
+uint64_t coveredSamplingPeriods();
+
+/* hooks between the individual fakes */
+void setSerialVerbose(bool enabled);
+void configureMac(const options_t &options);
+uint64_t nextJobUs();
+bool idleUntil(uint64_t us);
+void recordQueued();
+void recordUplink(uint8_t datarate, uint8_t channel, const uint8_t *payload, uint8_t length, uint32_t airtimeUs);
+void recordJoinRequest(uint8_t datarate, uint32_t airtimeUs);
+void onSensorRead();
+void onLedWrite(int value);
+uint32_t random(uint32_t bound);
+
+}
+
+#define SIM_SECONDS(S) (static_cast<uint64_t>(S) * 1000000ULL)
+#define SIM_DAYS(D) (SIM_SECONDS(D) * 24 * 3600)
+
+#endif /* SIM_H */
@@ -0,0 +1,21 @@
+#include "standby.h"
+#include "sim.h"
+
+/*
+ * Standby in virtual time: the clock jumps to the end of the nap, which is
+ * accounted for as time asleep.
+ */
+
+bool Standby::begin() {
+  return true;
+}
+
+uint32_t Standby::sleepMillis(uint32_t millis) {
+  if (millis < STANDBY_MIN_MILLIS) return 0;
+
+  uint64_t startUs = sim::nowUs();
+  sim::idleUntil(startUs + static_cast<uint64_t>(millis) * 1000);
+  uint64_t sleptUs = sim::nowUs() - startUs;
+  sim::counters().asleepUs += sleptUs;
+  return sleptUs / 1000;
+}
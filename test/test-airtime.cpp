@@ -0,0 +1,111 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "airtime.h"
+#include "airtime_budget.h"
+
+#define NROF_ELEMENTS_OF(ARY) (sizeof(ARY) / sizeof(ARY[0]))
+
+// the airtime module must be usable at compile time
+static_assert(airtimeOfUplinkUs(0, 3) == 1318912, "SF12 airtime of a 3-byte uplink");
+
+TEST_CASE("Uplink airtimes match the Semtech LoRa calculator", "[airtime]") {
+  struct ExpectedAirtimes {
+    uint8_t datarate;
+    uint8_t payloadSize;
+    uint32_t airtimeUs;
+  };
+
+  // the payload size excludes the 13 bytes of LoRaWAN overhead
+  struct ExpectedAirtimes expectedAirtimes[] = {
+    { .datarate = 6, .payloadSize = 3, .airtimeUs = 25728 },
+    { .datarate = 5, .payloadSize = 3, .airtimeUs = 51456 },
+    { .datarate = 4, .payloadSize = 5, .airtimeUs = 92672 },
+    { .datarate = 3, .payloadSize = 7, .airtimeUs = 185344 },
+    { .datarate = 2, .payloadSize = 11, .airtimeUs = 370688 },
+    { .datarate = 1, .payloadSize = 9, .airtimeUs = 741376 },
+    { .datarate = 0, .payloadSize = 3, .airtimeUs = 1318912 },
+    { .datarate = 0, .payloadSize = 11, .airtimeUs = 1482752 },
+    { .datarate = 0, .payloadSize = 51, .airtimeUs = 2793472 }
+  };
+
+  for (unsigned int i = 0; i < NROF_ELEMENTS_OF(expectedAirtimes); i++) {
+    REQUIRE(airtimeOfUplinkUs(expectedAirtimes[i].datarate, expectedAirtimes[i].payloadSize)
+        == expectedAirtimes[i].airtimeUs);
+  }
+}
+
+TEST_CASE("Low datarate optimization applies to SF11 and SF12 only", "[airtime]") {
+  for (uint8_t datarate = 0; datarate <= 6; datarate++) {
+    REQUIRE(airtimeParametersOfDatarate(datarate).lowDataRateOptimize == (datarate <= 1));
+  }
+
+  lora_parameters_t sf12 = airtimeParametersOfDatarate(0);
+  uint32_t optimized = airtimeUs(sf12, 24);
+  sf12.lowDataRateOptimize = false;
+  REQUIRE(airtimeUs(sf12, 24) < optimized);
+}
+
+TEST_CASE("Airtime grows in steps of whole symbol blocks", "[airtime]") {
+  // SF12 with LDRO carries 5 bytes per block of 5 symbols
+  REQUIRE(airtimeOfUplinkUs(0, 3) == airtimeOfUplinkUs(0, 7));
+  REQUIRE(airtimeOfUplinkUs(0, 8) - airtimeOfUplinkUs(0, 7) == 5 * airtimeSymbolUs(airtimeParametersOfDatarate(0)));
+}
+
+TEST_CASE("Transmission intervals respect the TTN airtime budget", "[airtime]") {
+  for (uint8_t datarate = 0; datarate <= 6; datarate++) {
+    uint32_t airtime = airtimeOfUplinkUs(datarate, 11);
+    uint32_t interval = airtimeMinTransmissionIntervalSecs(airtime);
+    REQUIRE(static_cast<uint64_t>(airtime) * AIRTIME_SECONDS_PER_DAY <= static_cast<uint64_t>(AIRTIME_TTN_BUDGET_US_PER_DAY) * interval);
+    REQUIRE(static_cast<uint64_t>(airtime) * AIRTIME_SECONDS_PER_DAY > static_cast<uint64_t>(AIRTIME_TTN_BUDGET_US_PER_DAY) * (interval - 1));
+  }
+}
+
+TEST_CASE("The airtime budget forgets uplinks after 24 hours", "[airtime]") {
+  AirtimeBudget budget;
+
+  budget.charge(20 * 1000 * 1000);
+  REQUIRE(budget.allows(10 * 1000 * 1000));
+  REQUIRE_FALSE(budget.allows(10 * 1000 * 1000 + 1));
+
+  for (int hour = 0; hour < 24; hour++) budget.advance(3600);
+  REQUIRE(budget.usedUs() == 20 * 1000 * 1000);
+
+  budget.advance(3600);
+  REQUIRE(budget.usedUs() == 0);
+}
+
+TEST_CASE("The airtime allowance spreads the daily budget evenly", "[airtime]") {
+  AirtimeBudget budget;
+  uint32_t nominal = AIRTIME_TTN_BUDGET_US_PER_DAY / 24;
+
+  REQUIRE(budget.allowanceUsPerHour() == nominal);
+
+  // spending the nominal share every hour keeps the allowance steady
+  for (int hour = 0; hour < 48; hour++) {
+    budget.charge(budget.allowanceUsPerHour());
+    budget.advance(3600);
+    REQUIRE(budget.allowanceUsPerHour() == nominal);
+  }
+}
+
+TEST_CASE("The airtime allowance compensates under- and overspending", "[airtime]") {
+  uint32_t nominal = AIRTIME_TTN_BUDGET_US_PER_DAY / 24;
+
+  AirtimeBudget underspent;
+  for (int hour = 0; hour < 24; hour++) {
+    underspent.charge(nominal / 2);
+    underspent.advance(3600);
+  }
+  REQUIRE(underspent.allowanceUsPerHour() > nominal);
+
+  AirtimeBudget overspent;
+  overspent.charge(AIRTIME_TTN_BUDGET_US_PER_DAY / 2);
+  overspent.advance(3600);
+  REQUIRE(overspent.allowanceUsPerHour() < nominal);
+
+  AirtimeBudget exhausted;
+  exhausted.charge(AIRTIME_TTN_BUDGET_US_PER_DAY);
+  exhausted.advance(3600);
+  REQUIRE(exhausted.allowanceUsPerHour() == 0);
+}
@@ -0,0 +1,431 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "clair.h"
+#include "clairchen_config.h"
+#include "tools/clairchen_decoder.h"
+#include <vector>
+
+/*
+ * The CO2 concentration rises by 1 ppm every 3 s, so that the difference
+ * between two samples tells the time between them.
+ */
+class ClockSensor final : public Sensor {
+  public:
+    uint32_t seconds = 0;
+
+    bool setup() override { return true; }
+    bool measurementFailed() override { return false; }
+    clair_sample_t sampleMeasurements() override {
+      clair_sample_t sample = { static_cast<uint16_t>(400 + seconds / 3), 2000, 4000 };
+      return sample;
+    }
+};
+
+class SettableSensor final : public Sensor {
+  public:
+    clair_sample_t sample = { 500, 2000, 4000 };
+
+    bool setup() override { return true; }
+    bool measurementFailed() override { return false; }
+    clair_sample_t sampleMeasurements() override { return sample; }
+};
+
+/*
+ * At the shortest sampling period, the clock rises by a quantization step of
+ * CO2 per sample, so a sample may land just beyond the rounding boundary
+ * next to the last transmitted one. It is always sent.
+ */
+struct ClockConfig : ClairchenConfig {
+  static constexpr uint16_t HEARTBEAT_INTERVAL_SECS = 0;
+};
+
+typedef Clair<ClockSensor, ClockConfig> TestClair;
+
+// measures until a message is due, and returns it decoded
+static decoded_message_t nextMessage(TestClair &clair, ClockSensor &sensor) {
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  uint8_t length = 0;
+  while (length == 0) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+    if (clair.isMessageDue()) length = clair.encodeMessage(message, sizeof(message));
+    REQUIRE(sensor.seconds < 4 * 3600);
+  }
+  clair.commitMessage();
+
+  decoded_message_t decoded;
+  REQUIRE(decodeClairchenMessage(message, length, &decoded));
+  return decoded;
+}
+
+static void requireEquispaced(const decoded_message_t &message) {
+  REQUIRE(message.samplingPeriodSeconds > 0);
+  for (uint8_t i = 1; i < message.numberOfSamples; i++) {
+    int32_t deltaPpm = message.samples[i].co2ppm - message.samples[i - 1].co2ppm;
+    // CO2 is sent in steps of 20 ppm
+    REQUIRE(deltaPpm >= message.samplingPeriodSeconds / 3 - 20);
+    REQUIRE(deltaPpm <= message.samplingPeriodSeconds / 3 + 20);
+  }
+}
+
+TEST_CASE("A new datarate changes the sampling period with the next message", "[clair]") {
+  ClockSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+  transmission_config_t fast = clair.getTransmissionConfig();
+
+  decoded_message_t message = nextMessage(clair, sensor);
+  REQUIRE(message.samplingPeriodSeconds == fast.samplingPeriodSeconds);
+  requireEquispaced(message);
+
+  // ADR slows the node down while the next message is half full
+  for (uint32_t end = sensor.seconds + fast.samplingPeriodSeconds * fast.samplesPerMessage / 2; sensor.seconds < end;) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+  clair.setCurrentDatarate(0);
+  transmission_config_t slow = clair.getTransmissionConfig();
+  REQUIRE(slow.samplingPeriodSeconds > fast.samplingPeriodSeconds);
+
+  // the samples taken so far are sent at the previous sampling period
+  message = nextMessage(clair, sensor);
+  REQUIRE(message.samplingPeriodSeconds == fast.samplingPeriodSeconds);
+  requireEquispaced(message);
+
+  message = nextMessage(clair, sensor);
+  REQUIRE(message.samplingPeriodSeconds == slow.samplingPeriodSeconds);
+  requireEquispaced(message);
+}
+
+TEST_CASE("The sampling period is planned from the airtime allowance of the datarate", "[clair]") {
+  ClockSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+
+  const uint16_t minPeriod = ClairchenConfig::MIN_SAMPLING_PERIOD_SECS;
+  const uint8_t maxSamples = ClairchenConfig::MAX_NROF_SAMPLES_PER_MESSAGE;
+  uint16_t previousPeriod = ClairchenConfig::MAX_SAMPLING_PERIOD_SECS;
+  for (int datarate = 0; datarate < CLAIR_NROF_DATARATES; datarate++) {
+    clair.setCurrentDatarate(datarate);
+    transmission_config_t config = clair.getTransmissionConfig();
+    REQUIRE(config.samplingPeriodSeconds >= minPeriod);
+    REQUIRE(config.samplingPeriodSeconds % ClairchenConfig::SAMPLING_PERIOD_UNIT_SECS == 0);
+    REQUIRE(config.samplesPerMessage >= 1);
+    REQUIRE(config.samplesPerMessage <= maxSamples);
+
+    // faster datarates sample at least as often
+    REQUIRE(config.samplingPeriodSeconds <= previousPeriod);
+    previousPeriod = config.samplingPeriodSeconds;
+  }
+
+  // SF12 spends the budget on few long uplinks, SF7 reaches the shortest sampling period
+  clair.setCurrentDatarate(0);
+  REQUIRE(clair.getTransmissionConfig().samplingPeriodSeconds > minPeriod);
+  clair.setCurrentDatarate(5);
+  REQUIRE(clair.getTransmissionConfig().samplingPeriodSeconds == minPeriod);
+}
+
+TEST_CASE("Sending every due message keeps within the daily airtime budget and uses most of it", "[clair]") {
+  // the clock would run out of range, and unchanged samples are sent all the same
+  SettableSensor sensor;
+  Clair<SettableSensor, ClockConfig> clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(0);
+
+  std::vector<uint32_t> times;
+  std::vector<uint32_t> airtimes;
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  for (uint32_t seconds = 0; seconds < 3 * AIRTIME_SECONDS_PER_DAY;) {
+    seconds += clair.getSecondsUntilNextMeasurement();
+    sensor.sample.co2ppm = 500 + seconds / 60 % 20;
+    REQUIRE(clair.getCO2Concentration() >= 0);
+    if (!clair.isMessageDue()) continue;
+
+    uint8_t length = clair.encodeMessage(message, sizeof(message));
+    REQUIRE(length > 0);
+    clair.commitMessage();
+    times.push_back(seconds);
+    airtimes.push_back(airtimeOfUplinkUs(0, length));
+  }
+
+  // in any 24 h window
+  uint64_t lastDayUs = 0;
+  for (size_t i = 0, first = 0; i < times.size(); i++) {
+    lastDayUs += airtimes[i];
+    while (times[i] - times[first] >= AIRTIME_SECONDS_PER_DAY) lastDayUs -= airtimes[first++];
+    REQUIRE(lastDayUs <= AIRTIME_TTN_BUDGET_US_PER_DAY);
+  }
+  REQUIRE(lastDayUs >= AIRTIME_TTN_BUDGET_US_PER_DAY * 8 / 10);
+}
+
+TEST_CASE("Queued samples of different sampling periods are sent in separate messages", "[clair]") {
+  ClockSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+  transmission_config_t fast = clair.getTransmissionConfig();
+
+  // the radio is busy for two hours, so that messages queue up; ADR slows the node down meanwhile
+  bool slowedDown = false;
+  while (sensor.seconds < 2 * 3600) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+    if (sensor.seconds >= 10 * 60 && !slowedDown) {
+      clair.setCurrentDatarate(0);
+      slowedDown = true;
+    }
+  }
+
+  transmission_config_t slow = clair.getTransmissionConfig();
+  REQUIRE(slow.samplingPeriodSeconds > fast.samplingPeriodSeconds);
+  REQUIRE(clair.isMessageDue());
+
+  // the samples of the previous sampling period go first
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  uint8_t length = clair.encodeMessage(message, sizeof(message));
+  clair.commitMessage();
+  decoded_message_t decoded;
+  REQUIRE(decodeClairchenMessage(message, length, &decoded));
+  REQUIRE(decoded.samplingPeriodSeconds == fast.samplingPeriodSeconds);
+  requireEquispaced(decoded);
+
+  // the message tells the age of its last sample, within the quantization of the CO2 clock
+  uint32_t ageSeconds = sensor.seconds - (decoded.samples[decoded.numberOfSamples - 1].co2ppm - 400) * 3;
+  REQUIRE(decoded.transmissionDelaySeconds >= ageSeconds - 60);
+  REQUIRE(decoded.transmissionDelaySeconds <= ageSeconds + 60);
+
+  decoded = nextMessage(clair, sensor);
+  REQUIRE(decoded.samplingPeriodSeconds == slow.samplingPeriodSeconds);
+  requireEquispaced(decoded);
+}
+
+TEST_CASE("Messages tell the age of their last sample at transmission", "[clair]") {
+  ClockSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+
+  while (!clair.isMessageDue()) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+
+  // the last sample has just been taken
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  uint8_t length = clair.encodeMessage(message, sizeof(message));
+  decoded_message_t decoded;
+  REQUIRE(decodeClairchenMessage(message, length, &decoded));
+  REQUIRE(decoded.version == 2);
+  REQUIRE(decoded.transmissionDelaySeconds == 0);
+
+  // the radio was busy for a while after the measurement
+  uint8_t delayedLength = clair.encodeMessage(message, sizeof(message), 7);
+  REQUIRE(delayedLength == length + 1);
+  REQUIRE(decodeClairchenMessage(message, delayedLength, &decoded));
+  REQUIRE(decoded.transmissionDelaySeconds == 7);
+  REQUIRE(decoded.samples[decoded.numberOfSamples - 1].ageSeconds == 7);
+
+  delayedLength = clair.encodeMessage(message, sizeof(message), 3 * 3600);
+  REQUIRE(delayedLength == length + 2);
+  REQUIRE(decodeClairchenMessage(message, delayedLength, &decoded));
+  REQUIRE(decoded.transmissionDelaySeconds == 3 * 3600);
+
+  // beyond 4.5 h, in coarser units
+  delayedLength = clair.encodeMessage(message, sizeof(message), 15 * 3600 + 2);
+  REQUIRE(delayedLength == length + 2);
+  REQUIRE(decodeClairchenMessage(message, delayedLength, &decoded));
+  REQUIRE(decoded.transmissionDelaySeconds == 15 * 3600);
+}
+
+TEST_CASE("Samples end on multiples of the sampling period in wall-clock time once it is known", "[clair]") {
+  ClockSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+  REQUIRE(clair.isWallClockSyncDue());
+
+  sensor.seconds += clair.getSecondsUntilNextMeasurement();
+  REQUIRE(clair.getCO2Concentration() >= 0);
+  // the wall-clock time is off the grid of the measuring period
+  const uint32_t gpsSeconds = 1298635413;
+  clair.setWallClockSeconds(gpsSeconds);
+  // the grid is aligned to UTC, which is behind GPS time
+  const uint32_t wallClockOffset = gpsSeconds - ClairchenConfig::GPS_UTC_OFFSET_SECS - sensor.seconds;
+  const uint32_t setSeconds = sensor.seconds;
+  REQUIRE_FALSE(clair.isWallClockSyncDue());
+  REQUIRE((sensor.seconds + wallClockOffset + clair.getSecondsUntilNextMeasurement()) % ClairchenConfig::MEASURING_PERIOD_SECS == 0);
+
+  // the message in progress keeps its phase, the next ones are aligned
+  nextMessage(clair, sensor);
+  for (int i = 0; i < 3; i++) {
+    decoded_message_t message = nextMessage(clair, sensor);
+    requireEquispaced(message);
+    uint32_t endSeconds = sensor.seconds - message.transmissionDelaySeconds + wallClockOffset;
+    REQUIRE(endSeconds % message.samplingPeriodSeconds == 0);
+  }
+
+  // to make up for clock drift, the wall-clock time is due again after a while
+  while (!clair.isWallClockSyncDue()) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+  const uint32_t syncInterval = ClairchenConfig::WALL_CLOCK_SYNC_INTERVAL_SECS;
+  REQUIRE(sensor.seconds - setSeconds >= syncInterval);
+}
+
+/*
+ * The readings of an empty room, which dither across the rounding boundaries
+ * of 410 ppm, 20.5 °C and 45 % from one measurement to the next
+ */
+class DitheringSensor final : public Sensor {
+  public:
+    uint32_t seconds = 0;
+
+    bool setup() override { return true; }
+    bool measurementFailed() override { return false; }
+    clair_sample_t sampleMeasurements() override {
+      dither = !dither;
+      clair_sample_t sample = dither
+        ? clair_sample_t { 409, 2049, 4499 }
+        : clair_sample_t { 411, 2051, 4501 };
+      return sample;
+    }
+
+  private:
+    bool dither = false;
+};
+
+TEST_CASE("Samples that dither across a rounding boundary count as unchanged", "[clair]") {
+  DitheringSensor sensor;
+  Clair<DitheringSensor, ClairchenConfig> clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  while (!clair.isMessageDue()) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+  REQUIRE(clair.encodeMessage(message, sizeof(message)) > 0);
+  clair.commitMessage();
+  const uint32_t sentSeconds = sensor.seconds;
+
+  // the averages of the following sampling periods differ in the last bit, but are not sent
+  while (!clair.isMessageDue()) {
+    sensor.seconds += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+  const uint32_t heartbeatInterval = ClairchenConfig::HEARTBEAT_INTERVAL_SECS;
+  REQUIRE(sensor.seconds - sentSeconds >= heartbeatInterval);
+
+  uint8_t length = clair.encodeMessage(message, sizeof(message));
+  decoded_message_t decoded;
+  REQUIRE(decodeClairchenMessage(message, length, &decoded));
+  REQUIRE(decoded.messageId == CLAIR_MESSAGE_ID_HEARTBEAT);
+}
+
+TEST_CASE("An alert stays due until it is committed", "[clair]") {
+  SettableSensor sensor;
+  Clair<SettableSensor, ClairchenConfig> clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+
+  for (int i = 0; i < 3; i++) REQUIRE(clair.getCO2Concentration() >= 0);
+  REQUIRE_FALSE(clair.isAlertDue());
+
+  sensor.sample.co2ppm = 1500;
+  REQUIRE(clair.getCO2Concentration() >= 0);
+  REQUIRE(clair.isAlertDue());
+
+  // e.g., LMIC did not accept the alert
+  uint8_t message[Clair<SettableSensor, ClairchenConfig>::ALERT_MESSAGE_SIZE];
+  REQUIRE(clair.encodeAlert(message, sizeof(message)) == sizeof(message));
+  REQUIRE(clair.isAlertDue());
+
+  REQUIRE(clair.encodeAlert(message, sizeof(message)) == sizeof(message));
+  clair.commitMessage();
+  REQUIRE_FALSE(clair.isAlertDue());
+
+  // the next change of the air quality has to wait for the minimum alert interval
+  sensor.sample.co2ppm = 500;
+  REQUIRE(clair.getCO2Concentration() >= 0);
+  REQUIRE_FALSE(clair.isAlertDue());
+}
+
+typedef Clair<SettableSensor, ClairchenConfig> AlertingClair;
+
+static void measureFor(AlertingClair &clair, uint32_t seconds) {
+  for (uint32_t elapsed = 0; elapsed < seconds;) {
+    elapsed += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+}
+
+static decoded_message_t sendAlert(AlertingClair &clair) {
+  uint8_t message[AlertingClair::ALERT_MESSAGE_SIZE];
+  uint8_t length = clair.encodeAlert(message, sizeof(message));
+  REQUIRE(length == sizeof(message));
+  clair.commitMessage();
+
+  decoded_message_t decoded;
+  REQUIRE(decodeClairchenMessage(message, length, &decoded));
+  REQUIRE(decoded.messageId == CLAIR_MESSAGE_ID_ALERT);
+  return decoded;
+}
+
+TEST_CASE("An alert is due once the air quality category changes beyond the hysteresis", "[clair]") {
+  SettableSensor sensor;
+  AlertingClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+
+  sensor.sample.co2ppm = 680;
+  measureFor(clair, 5 * 60);
+  REQUIRE_FALSE(clair.isAlertDue());
+
+  // just across the threshold of 700 ppm
+  sensor.sample.co2ppm = 720;
+  measureFor(clair, 5 * 60);
+  REQUIRE_FALSE(clair.isAlertDue());
+
+  sensor.sample.co2ppm = 740;
+  measureFor(clair, ClairchenConfig::MEASURING_PERIOD_SECS);
+  REQUIRE(clair.isAlertDue());
+  decoded_message_t alert = sendAlert(clair);
+  REQUIRE(alert.airQuality == static_cast<uint8_t>(CO2AirQuality::fair));
+  REQUIRE(alert.samples[0].co2ppm == 740);
+
+  // back below the threshold, after the minimum alert interval
+  sensor.sample.co2ppm = 660;
+  measureFor(clair, ClairchenConfig::MIN_ALERT_INTERVAL_SECS - 60);
+  REQUIRE_FALSE(clair.isAlertDue());
+  measureFor(clair, 60);
+  REQUIRE(clair.isAlertDue());
+  REQUIRE(sendAlert(clair).airQuality == static_cast<uint8_t>(CO2AirQuality::good));
+}
+
+TEST_CASE("An alert is due once the CO2 concentration rises steeply, and tells the trend", "[clair]") {
+  SettableSensor sensor;
+  AlertingClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(5);
+
+  sensor.sample.co2ppm = 500;
+  measureFor(clair, 5 * 60);
+  REQUIRE_FALSE(clair.isAlertDue());
+
+  // 120 ppm per minute, e.g., people arriving, still within the category
+  uint32_t seconds = 0;
+  while (!clair.isAlertDue()) {
+    seconds += clair.getSecondsUntilNextMeasurement();
+    sensor.sample.co2ppm = 500 + seconds * 2;
+    REQUIRE(clair.getCO2Concentration() >= 0);
+    REQUIRE(seconds <= 2 * 60);
+  }
+  decoded_message_t alert = sendAlert(clair);
+  REQUIRE(alert.airQuality == static_cast<uint8_t>(CO2AirQuality::good));
+  REQUIRE(alert.co2TrendPpmPerMinute >= 50);
+  REQUIRE(alert.co2TrendPpmPerMinute <= 120);
+}
@@ -0,0 +1,59 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "decimation_filter.h"
+
+static clair_sample_t measurement(uint16_t co2ppm, int16_t temperatureCentiDegrees, uint16_t humidityCentiPercent) {
+  clair_sample_t sample;
+  sample.co2ppm = co2ppm;
+  sample.temperatureCentiDegrees = temperatureCentiDegrees;
+  sample.humidityCentiPercent = humidityCentiPercent;
+  return sample;
+}
+
+TEST_CASE("The decimation filter averages all measurements of a period", "[decimation]") {
+  DecimationFilter filter;
+
+  filter.add(measurement(400, 2000, 4000));
+  filter.add(measurement(600, 2200, 5000));
+  filter.add(measurement(801, 2401, 6001));
+
+  REQUIRE(filter.count() == 3);
+  clair_sample_t average = filter.average();
+  REQUIRE(average.co2ppm == 600);
+  REQUIRE(average.temperatureCentiDegrees == 2200);
+  REQUIRE(average.humidityCentiPercent == 5000);
+}
+
+TEST_CASE("The decimation filter rounds averages to the nearest value", "[decimation]") {
+  DecimationFilter filter;
+
+  filter.add(measurement(400, 2000, 4000));
+  filter.add(measurement(401, 2001, 4001));
+  clair_sample_t average = filter.average();
+  REQUIRE(average.co2ppm == 401);
+  REQUIRE(average.temperatureCentiDegrees == 2001);
+  REQUIRE(average.humidityCentiPercent == 4001);
+
+  filter.reset();
+  filter.add(measurement(400, -500, 4000));
+  filter.add(measurement(400, -501, 4000));
+  REQUIRE(filter.average().temperatureCentiDegrees == -501);
+}
+
+TEST_CASE("The decimation filter handles the longest sampling period", "[decimation]") {
+  DecimationFilter filter;
+
+  // 14 minutes of measurements every 5 s at the upper end of the SCD30 range
+  for (int i = 0; i < 14 * 60 / 5; i++) {
+    filter.add(measurement(10000, 7000, 10000));
+  }
+  REQUIRE(filter.average().co2ppm == 10000);
+  REQUIRE(filter.average().temperatureCentiDegrees == 7000);
+  REQUIRE(filter.average().humidityCentiPercent == 10000);
+
+  filter.reset();
+  REQUIRE(filter.count() == 0);
+  filter.add(measurement(500, 2100, 4500));
+  REQUIRE(filter.average().co2ppm == 500);
+}
@@ -0,0 +1,291 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "clairchen_codec.h"
+#include "clair_protocol.h"
+#include "tools/clairchen_decoder.h"
+
+#define NROF_ELEMENTS_OF(ARY) (sizeof(ARY) / sizeof(ARY[0]))
+
+// samples on the quantization grid, so that they survive the round trip
+static clair_sample_t sample(uint16_t co2ppm, int16_t temperature, uint16_t humidity) {
+  clair_sample_t sample;
+  sample.co2ppm = co2ppm;
+  sample.temperatureCentiDegrees = temperature * 100;
+  sample.humidityCentiPercent = humidity * 100;
+  return sample;
+}
+
+static void requireDecodedSamples(const decoded_message_t &message, const clair_sample_t *samples, uint8_t numberOfSamples) {
+  REQUIRE(message.numberOfSamples == numberOfSamples);
+  for (uint8_t i = 0; i < numberOfSamples; i++) {
+    REQUIRE(message.samples[i].co2ppm == samples[i].co2ppm);
+    REQUIRE(message.samples[i].temperature == samples[i].temperatureCentiDegrees / 100);
+    REQUIRE(message.samples[i].humidity == samples[i].humidityCentiPercent / 100);
+  }
+}
+
+static uint8_t header(uint8_t messageId, uint8_t messageHeader, uint8_t version = CLAIR_PROTOCOL_VERSION) {
+  return version << 6 | messageId << 3 | messageHeader;
+}
+
+// an unoccupied room with a few people coming in
+static const clair_sample_t series[] = {
+  sample(420, 20, 40), sample(420, 20, 40), sample(440, 20, 40), sample(420, 20, 40),
+  sample(420, 20, 40), sample(420, 20, 40), sample(400, 20, 40), sample(420, 20, 40),
+  sample(420, 20, 40), sample(440, 20, 40), sample(440, 21, 40), sample(520, 21, 40),
+  sample(640, 21, 50), sample(700, 21, 50), sample(720, 21, 50), sample(720, 22, 50)
+};
+
+TEST_CASE("Plain sample lists are decoded", "[decoder]") {
+  uint8_t payload[CLAIR_HEADER_SIZE + 8 * ClairchenCodec::SAMPLE_SIZE];
+  payload[0] = header(CLAIR_MESSAGE_ID_SAMPLE_LIST, 8 - 1);
+  payload[1] = 36; // 3 min
+  for (uint8_t i = 0; i < 8; i++) {
+    ClairchenCodec::encodeSample(series[i], payload + CLAIR_HEADER_SIZE + i * ClairchenCodec::SAMPLE_SIZE);
+  }
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, sizeof(payload), &message));
+  REQUIRE(message.version == CLAIR_PROTOCOL_VERSION);
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_SAMPLE_LIST);
+  REQUIRE(message.samplingPeriodSeconds == 180);
+  requireDecodedSamples(message, series, 8);
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, sizeof(payload) - 1, &message));
+}
+
+TEST_CASE("Delta-encoded sample lists are decoded", "[decoder]") {
+  uint8_t payload[64];
+  payload[0] = header(CLAIR_MESSAGE_ID_DELTA_LIST, 8 - 1);
+  payload[1] = 36;
+  uint8_t length = ClairchenCodec::encodeDeltaSamples(series + 8, 8, payload + CLAIR_HEADER_SIZE,
+      sizeof(payload) - CLAIR_HEADER_SIZE);
+  REQUIRE(length > 0);
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length, &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_DELTA_LIST);
+  requireDecodedSamples(message, series + 8, 8);
+}
+
+TEST_CASE("Rice-coded sample lists are decoded", "[decoder]") {
+  uint8_t payload[64];
+  uint8_t messageHeader;
+  uint8_t length = ClairchenCodec::encodeRiceSamples(series, NROF_ELEMENTS_OF(series), payload + CLAIR_HEADER_SIZE,
+      sizeof(payload) - CLAIR_HEADER_SIZE, &messageHeader);
+  REQUIRE(length > 0);
+  payload[0] = header(CLAIR_MESSAGE_ID_RICE_LIST, messageHeader);
+  payload[1] = 36;
+
+  // twice the samples of a plain list in less space
+  REQUIRE(length < 8 * ClairchenCodec::SAMPLE_SIZE);
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length, &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_RICE_LIST);
+  requireDecodedSamples(message, series, NROF_ELEMENTS_OF(series));
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + 3, &message));
+}
+
+TEST_CASE("Rice coding handles large deltas", "[decoder]") {
+  clair_sample_t jumps[] = { sample(400, 10, 10), sample(5100, 31, 80), sample(0, 0, 10), sample(2000, 15, 40) };
+  uint8_t payload[64];
+  uint8_t messageHeader;
+  uint8_t length = ClairchenCodec::encodeRiceSamples(jumps, NROF_ELEMENTS_OF(jumps), payload + CLAIR_HEADER_SIZE,
+      sizeof(payload) - CLAIR_HEADER_SIZE, &messageHeader);
+  REQUIRE(length > 0);
+  payload[0] = header(CLAIR_MESSAGE_ID_RICE_LIST, messageHeader);
+  payload[1] = 12;
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length, &message));
+  requireDecodedSamples(message, jumps, NROF_ELEMENTS_OF(jumps));
+}
+
+TEST_CASE("Breakpoint lists are decoded with the ages of their breakpoints", "[decoder]") {
+  clair_sample_t breakpoints[] = { sample(420, 20, 40), sample(420, 20, 40), sample(820, 22, 50) };
+  uint8_t offsets[] = { 12, 255, 60 }; // in units of 5 s
+  uint8_t payload[CLAIR_HEADER_SIZE + 3 * (CLAIR_BREAKPOINT_OFFSET_SIZE + ClairchenCodec::SAMPLE_SIZE)];
+  payload[0] = header(CLAIR_MESSAGE_ID_BREAKPOINT_LIST, 3 - 1);
+  payload[1] = 2;
+  for (uint8_t i = 0; i < 3; i++) {
+    uint8_t *breakpoint = payload + CLAIR_HEADER_SIZE + i * (CLAIR_BREAKPOINT_OFFSET_SIZE + ClairchenCodec::SAMPLE_SIZE);
+    breakpoint[0] = offsets[i];
+    ClairchenCodec::encodeSample(breakpoints[i], breakpoint + CLAIR_BREAKPOINT_OFFSET_SIZE);
+  }
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, sizeof(payload), &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_BREAKPOINT_LIST);
+  REQUIRE(message.samplingPeriodSeconds == 0);
+  REQUIRE(message.precedingGapSeconds == 60);
+  requireDecodedSamples(message, breakpoints, 3);
+  REQUIRE(message.samples[2].ageSeconds == 10);
+  REQUIRE(message.samples[1].ageSeconds == 310);
+  REQUIRE(message.samples[0].ageSeconds == 1585);
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, sizeof(payload) - 1, &message));
+}
+
+TEST_CASE("The series is rebuilt by linear interpolation", "[decoder]") {
+  decoded_message_t message;
+  message.numberOfSamples = 3;
+  message.samples[0] = { 400, 20, 40, 600 };
+  message.samples[1] = { 400, 20, 40, 300 };
+  message.samples[2] = { 1000, 23, 60, 0 };
+
+  decoded_sample_t series[16];
+  uint16_t count = reconstructClairchenSeries(&message, 100, series, NROF_ELEMENTS_OF(series));
+  REQUIRE(count == 7);
+  REQUIRE(series[0].ageSeconds == 600);
+  REQUIRE(series[3].co2ppm == 400);
+  REQUIRE(series[4].ageSeconds == 200);
+  REQUIRE(series[4].co2ppm == 600);
+  REQUIRE(series[4].temperature == 21);
+  REQUIRE(series[5].co2ppm == 800);
+  REQUIRE(series[5].humidity == 53);
+  REQUIRE(series[6].co2ppm == 1000);
+  REQUIRE(series[6].ageSeconds == 0);
+
+  REQUIRE(reconstructClairchenSeries(&message, 100, series, 2) == 2);
+}
+
+TEST_CASE("Sample lists get equispaced ages", "[decoder]") {
+  uint8_t payload[CLAIR_HEADER_SIZE + 2 * ClairchenCodec::SAMPLE_SIZE];
+  payload[0] = header(CLAIR_MESSAGE_ID_SAMPLE_LIST, 2 - 1);
+  payload[1] = 12;
+  ClairchenCodec::encodeSample(series[0], payload + CLAIR_HEADER_SIZE);
+  ClairchenCodec::encodeSample(series[1], payload + CLAIR_HEADER_SIZE + ClairchenCodec::SAMPLE_SIZE);
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, sizeof(payload), &message));
+  REQUIRE(message.samples[0].ageSeconds == 60);
+  REQUIRE(message.samples[1].ageSeconds == 0);
+}
+
+TEST_CASE("Alerts are decoded", "[decoder]") {
+  uint8_t payload[CLAIR_HEADER_SIZE + ClairchenCodec::SAMPLE_SIZE];
+  payload[0] = header(CLAIR_MESSAGE_ID_ALERT, 3); // bad
+  payload[1] = static_cast<uint8_t>(-14);
+  ClairchenCodec::encodeSample(sample(1100, 22, 50), payload + CLAIR_HEADER_SIZE);
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, sizeof(payload), &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_ALERT);
+  REQUIRE(message.airQuality == 3);
+  REQUIRE(message.co2TrendPpmPerMinute == -140);
+  REQUIRE(message.numberOfSamples == 1);
+  REQUIRE(message.samples[0].co2ppm == 1100);
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, sizeof(payload) - 1, &message));
+}
+
+TEST_CASE("Heartbeats are decoded", "[decoder]") {
+  uint8_t payload[CLAIR_HEADER_SIZE] = { header(CLAIR_MESSAGE_ID_HEARTBEAT, 0), 36 };
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, sizeof(payload), &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_HEARTBEAT);
+  REQUIRE(message.samplingPeriodSeconds == 180);
+  REQUIRE(message.numberOfSamples == 0);
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, 1, &message));
+}
+
+TEST_CASE("Version 1 sample lists sent from a backlog tell the number of samples queued after them", "[decoder]") {
+  uint8_t payload[64];
+  uint8_t messageHeader;
+  uint8_t length = ClairchenCodec::encodeRiceSamples(series, NROF_ELEMENTS_OF(series), payload + CLAIR_HEADER_SIZE,
+      sizeof(payload) - CLAIR_HEADER_SIZE, &messageHeader);
+  payload[0] = header(CLAIR_MESSAGE_ID_RICE_LIST, messageHeader, 1);
+  payload[1] = 12;
+  payload[CLAIR_HEADER_SIZE + length] = 20;
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + CLAIR_BACKLOG_SIZE, &message));
+  requireDecodedSamples(message, series, NROF_ELEMENTS_OF(series));
+  REQUIRE(message.backlogSamples == 20);
+  REQUIRE(message.samples[15].ageSeconds == 20 * 60);
+
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length, &message));
+  REQUIRE(message.backlogSamples == 0);
+  REQUIRE(message.samples[15].ageSeconds == 0);
+
+  // plain lists
+  payload[0] = header(CLAIR_MESSAGE_ID_SAMPLE_LIST, 0, 1);
+  ClairchenCodec::encodeSample(series[0], payload + CLAIR_HEADER_SIZE);
+  payload[CLAIR_HEADER_SIZE + ClairchenCodec::SAMPLE_SIZE] = 3;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + ClairchenCodec::SAMPLE_SIZE + CLAIR_BACKLOG_SIZE, &message));
+  REQUIRE(message.backlogSamples == 3);
+  REQUIRE(message.samples[0].ageSeconds == 3 * 60);
+}
+
+TEST_CASE("Version 2 sample lists tell the age of their last sample at transmission", "[decoder]") {
+  uint8_t payload[64];
+  uint8_t messageHeader;
+  uint8_t length = ClairchenCodec::encodeRiceSamples(series, NROF_ELEMENTS_OF(series), payload + CLAIR_HEADER_SIZE,
+      sizeof(payload) - CLAIR_HEADER_SIZE, &messageHeader);
+  payload[0] = header(CLAIR_MESSAGE_ID_RICE_LIST, messageHeader, 2);
+  payload[1] = 12;
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length, &message));
+  REQUIRE(message.transmissionDelaySeconds == 0);
+  REQUIRE(message.samples[15].ageSeconds == 0);
+
+  // 1 byte up to 127 s
+  payload[CLAIR_HEADER_SIZE + length] = 97;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + 1, &message));
+  requireDecodedSamples(message, series, NROF_ELEMENTS_OF(series));
+  REQUIRE(message.backlogSamples == 0);
+  REQUIRE(message.transmissionDelaySeconds == 97);
+  REQUIRE(message.samples[15].ageSeconds == 97);
+  REQUIRE(message.samples[0].ageSeconds == 97 + 15 * 60);
+
+  // 2 bytes beyond, here 5000 s
+  payload[CLAIR_HEADER_SIZE + length] = 0x80 | 0x13;
+  payload[CLAIR_HEADER_SIZE + length + 1] = 0x88;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + 2, &message));
+  REQUIRE(message.transmissionDelaySeconds == 5000);
+  REQUIRE(message.samples[14].ageSeconds == 5060);
+
+  // the second byte is missing
+  REQUIRE_FALSE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + 1, &message));
+
+  // in units of 5 s beyond, here 12 h
+  payload[CLAIR_HEADER_SIZE + length] = 0xC0 | 0x21;
+  payload[CLAIR_HEADER_SIZE + length + 1] = 0xC0;
+  REQUIRE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + 2, &message));
+  REQUIRE(message.transmissionDelaySeconds == 12 * 3600);
+
+  // too old to be dated
+  payload[CLAIR_HEADER_SIZE + length] = 0xFF;
+  payload[CLAIR_HEADER_SIZE + length + 1] = 0xFF;
+  REQUIRE_FALSE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + length + 2, &message));
+}
+
+TEST_CASE("Backfill lists are Rice coded and dated by the age of their last sample", "[decoder]") {
+  uint8_t payload[64];
+  uint8_t messageHeader;
+  const uint8_t headerSize = CLAIR_HEADER_SIZE + CLAIR_BACKFILL_AGE_SIZE;
+  uint8_t length = ClairchenCodec::encodeRiceSamples(series, NROF_ELEMENTS_OF(series), payload + headerSize,
+      sizeof(payload) - headerSize, &messageHeader);
+  payload[0] = header(CLAIR_MESSAGE_ID_BACKFILL_LIST, messageHeader);
+  payload[1] = 12;
+  // 300 minutes
+  payload[2] = 0x01;
+  payload[3] = 0x2C;
+
+  decoded_message_t message;
+  REQUIRE(decodeClairchenMessage(payload, headerSize + length, &message));
+  REQUIRE(message.messageId == CLAIR_MESSAGE_ID_BACKFILL_LIST);
+  REQUIRE(message.samplingPeriodSeconds == 60);
+  requireDecodedSamples(message, series, NROF_ELEMENTS_OF(series));
+  REQUIRE(message.backlogSamples == 0);
+  REQUIRE(message.samples[15].ageSeconds == 300 * 60);
+  REQUIRE(message.samples[0].ageSeconds == 300 * 60 + 15 * 60);
+
+  REQUIRE_FALSE(decodeClairchenMessage(payload, CLAIR_HEADER_SIZE + 1, &message));
+}
@@ -1,54 +1,53 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
-// we're testing static functions
-#include "../clair.cpp"
+#include "clairchen_codec.h"
 
 #define NROF_ELEMENTS_OF(ARY) (sizeof(ARY) / sizeof(ARY[0]))
 
 TEST_CASE("Temperature bytes are encoded correctly", "[clair]") {
   struct ExpectedEncodings {
-    float temperature;
+    int16_t temperatureCentiDegrees;
     uint8_t byte;
   };
 
   struct ExpectedEncodings expectedEncodings[] = {
-    { .temperature = -5.0, .byte = 0 },
-    { .temperature = 0.0, .byte = 0 },
-    { .temperature = 5.0, .byte = 5 },
-    { .temperature = 5.5, .byte = 6 },
-    { .temperature = 12.6, .byte = 13 },
-    { .temperature = 35.0, .byte = 31 }
+    { .temperatureCentiDegrees = -500, .byte = 0 },
+    { .temperatureCentiDegrees = 0, .byte = 0 },
+    { .temperatureCentiDegrees = 500, .byte = 5 },
+    { .temperatureCentiDegrees = 550, .byte = 6 },
+    { .temperatureCentiDegrees = 1260, .byte = 13 },
+    { .temperatureCentiDegrees = 3500, .byte = 31 }
   };
 
   for (unsigned int i = 0; i < NROF_ELEMENTS_OF(expectedEncodings); i++) {
-    REQUIRE(encodeTemperatureByte(expectedEncodings[i].temperature) == expectedEncodings[i].byte);
+    REQUIRE(ClairchenCodec::encodeTemperatureByte(expectedEncodings[i].temperatureCentiDegrees) == expectedEncodings[i].byte);
   }
 }
 
 TEST_CASE("Humidity bytes are encoded correctly", "[clair]") {
   struct ExpectedEncodings {
-    float humidity;
+    uint16_t humidityCentiPercent;
     uint8_t byte;
   };
 
   struct ExpectedEncodings expectedEncodings[] = {
-    { .humidity = 0.0, .byte = 0 },
-    { .humidity = 5.0, .byte = 0 },
-    { .humidity = 10.0, .byte = 0 },
-    { .humidity = 14.0, .byte = 0 },
-    { .humidity = 15.0, .byte = 1 },
-    { .humidity = 20.0, .byte = 1 },
-    { .humidity = 24.0, .byte = 1 },
-    { .humidity = 25.0, .byte = 2 },
-    { .humidity = 79.0, .byte = 7 },
-    { .humidity = 80.0, .byte = 7 },
-    { .humidity = 85.0, .byte = 7 },
-    { .humidity = 100.0, .byte = 7 }
+    { .humidityCentiPercent = 0, .byte = 0 },
+    { .humidityCentiPercent = 500, .byte = 0 },
+    { .humidityCentiPercent = 1000, .byte = 0 },
+    { .humidityCentiPercent = 1400, .byte = 0 },
+    { .humidityCentiPercent = 1500, .byte = 1 },
+    { .humidityCentiPercent = 2000, .byte = 1 },
+    { .humidityCentiPercent = 2400, .byte = 1 },
+    { .humidityCentiPercent = 2500, .byte = 2 },
+    { .humidityCentiPercent = 7900, .byte = 7 },
+    { .humidityCentiPercent = 8000, .byte = 7 },
+    { .humidityCentiPercent = 8500, .byte = 7 },
+    { .humidityCentiPercent = 10000, .byte = 7 }
   };
 
   for (unsigned int i = 0; i < NROF_ELEMENTS_OF(expectedEncodings); i++) {
-    REQUIRE(encodeHumidityByte(expectedEncodings[i].humidity) == expectedEncodings[i].byte);
+    REQUIRE(ClairchenCodec::encodeHumidityByte(expectedEncodings[i].humidityCentiPercent) == expectedEncodings[i].byte);
   }
 }
 
@@ -71,6 +70,102 @@ TEST_CASE("CO2 values are encoded correctly", "[clair]") {
   };
 
   for (unsigned int i = 0; i < NROF_ELEMENTS_OF(expectedEncodings); i++) {
-    REQUIRE(encodeCO2ppmByte(expectedEncodings[i].co2ppm) == expectedEncodings[i].byte);
+    REQUIRE(ClairchenCodec::encodeCO2ppmByte(expectedEncodings[i].co2ppm) == expectedEncodings[i].byte);
   }
 }
+
+static clair_sample_t sample(uint16_t co2ppm, int16_t temperatureCentiDegrees, uint16_t humidityCentiPercent) {
+  clair_sample_t sample;
+  sample.co2ppm = co2ppm;
+  sample.temperatureCentiDegrees = temperatureCentiDegrees;
+  sample.humidityCentiPercent = humidityCentiPercent;
+  return sample;
+}
+
+TEST_CASE("Decoded samples encode to the same bytes", "[clair]") {
+  clair_sample_t samples[] = {
+    sample(0, 0, 1000),
+    sample(415, 2149, 4490),
+    sample(5500, 3500, 9900)
+  };
+
+  for (unsigned int i = 0; i < NROF_ELEMENTS_OF(samples); i++) {
+    uint8_t encoded[ClairchenCodec::SAMPLE_SIZE];
+    uint8_t reencoded[ClairchenCodec::SAMPLE_SIZE];
+    ClairchenCodec::encodeSample(samples[i], encoded);
+    ClairchenCodec::encodeSample(ClairchenCodec::decodeSample(encoded), reencoded);
+    REQUIRE(reencoded[0] == encoded[0]);
+    REQUIRE(reencoded[1] == encoded[1]);
+  }
+
+  uint8_t encoded[] = { 21, 21 << 3 | 3 };
+  clair_sample_t decoded = ClairchenCodec::decodeSample(encoded);
+  REQUIRE(decoded.co2ppm == 420);
+  REQUIRE(decoded.temperatureCentiDegrees == 2100);
+  REQUIRE(decoded.humidityCentiPercent == 4000);
+}
+
+TEST_CASE("Samples encode alike if they only dither across a rounding boundary", "[clair]") {
+  uint8_t reference[ClairchenCodec::SAMPLE_SIZE];
+  ClairchenCodec::encodeSample(sample(409, 2049, 4499), reference);
+  REQUIRE(ClairchenCodec::encodesLike(sample(391, 1951, 3501), reference));
+
+  // each of the readings dithers across a rounding boundary
+  uint8_t dithered[ClairchenCodec::SAMPLE_SIZE];
+  ClairchenCodec::encodeSample(sample(411, 2051, 4501), dithered);
+  REQUIRE(dithered[0] != reference[0]);
+  REQUIRE(dithered[1] != reference[1]);
+  REQUIRE(ClairchenCodec::encodesLike(sample(411, 2051, 4501), reference));
+  REQUIRE(ClairchenCodec::encodesLike(sample(409, 2049, 4499), dithered));
+
+  // a quarter step beyond the boundary, the value decoded would be off by three quarters of a step
+  REQUIRE_FALSE(ClairchenCodec::encodesLike(sample(415, 2049, 4499), reference));
+  REQUIRE_FALSE(ClairchenCodec::encodesLike(sample(409, 2075, 4499), reference));
+  REQUIRE_FALSE(ClairchenCodec::encodesLike(sample(409, 2049, 4750), reference));
+  REQUIRE_FALSE(ClairchenCodec::encodesLike(sample(385, 2049, 4499), reference));
+
+  // readings beyond the range encode like its limits
+  ClairchenCodec::encodeSample(sample(5100, 3100, 8000), reference);
+  REQUIRE(ClairchenCodec::encodesLike(sample(6000, 3500, 9000), reference));
+}
+
+TEST_CASE("Samples are delta encoded correctly", "[clair]") {
+  clair_sample_t samples[] = {
+    sample(400, 2000, 4000),
+    sample(420, 2000, 4000),
+    sample(400, 2000, 5000),
+    sample(460, 2000, 4000)
+  };
+  uint8_t buffer[16];
+
+  uint8_t length = ClairchenCodec::encodeDeltaSamples(samples, NROF_ELEMENTS_OF(samples), buffer, sizeof(buffer));
+
+  // CO2 deltas +1, -1, +3 (3 bits), no temperature deltas, humidity deltas 0, +1, -1 (2 bits)
+  uint8_t expected[] = { 0x14, 0xA3, 0x32, 0x27, 0x5E };
+  REQUIRE(length == sizeof(expected));
+  for (unsigned int i = 0; i < sizeof(expected); i++) {
+    REQUIRE(buffer[i] == expected[i]);
+  }
+  REQUIRE(ClairchenCodec::compressedSamplesSize(NROF_ELEMENTS_OF(samples), 5) == sizeof(expected));
+}
+
+TEST_CASE("Constant samples take a single delta width byte", "[clair]") {
+  clair_sample_t samples[8];
+  for (unsigned int i = 0; i < NROF_ELEMENTS_OF(samples); i++) {
+    samples[i] = sample(800, 2100, 4500);
+  }
+  uint8_t buffer[16];
+
+  REQUIRE(ClairchenCodec::encodeDeltaSamples(samples, NROF_ELEMENTS_OF(samples), buffer, sizeof(buffer)) == 3);
+  REQUIRE(buffer[2] == 0);
+}
+
+TEST_CASE("Delta encoding fails for large deltas and small buffers", "[clair]") {
+  clair_sample_t temperatureJump[] = { sample(400, 1000, 4000), sample(400, 2000, 4000) };
+  clair_sample_t co2Jump[] = { sample(0, 2000, 4000), sample(5100, 2000, 4000) };
+  uint8_t buffer[16];
+
+  REQUIRE(ClairchenCodec::encodeDeltaSamples(temperatureJump, 2, buffer, sizeof(buffer)) == 0);
+  REQUIRE(ClairchenCodec::encodeDeltaSamples(co2Jump, 2, buffer, sizeof(buffer)) == 5);
+  REQUIRE(ClairchenCodec::encodeDeltaSamples(co2Jump, 2, buffer, 4) == 0);
+}
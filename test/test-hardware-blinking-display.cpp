@@ -0,0 +1,90 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "hardware_blinking_display.h"
+#include "fake_led_timer.h"
+#include <vector>
+
+/* milliseconds after the pattern started at which the LED changes, within the given time */
+static std::vector<uint32_t> edges(const FakeLedTimer &ledTimer, uint32_t millis) {
+  std::vector<uint32_t> result;
+  for (uint32_t t = 1; t < millis; t++) {
+    if (ledTimer.isOn(t) != ledTimer.isOn(t - 1)) result.push_back(t);
+  }
+  return result;
+}
+
+TEST_CASE("The LED blinks every second in good air", "[hardware-blinking-display]") {
+  FakeLedTimer ledTimer;
+  HardwareBlinkingDisplay display(&ledTimer);
+  display.setup();
+
+  REQUIRE(ledTimer.begun);
+  REQUIRE(ledTimer.plays == 1);
+  REQUIRE(ledTimer.isOn(0));
+  REQUIRE(edges(ledTimer, 4500) == std::vector<uint32_t>({ 1000, 2000, 3000, 4000 }));
+}
+
+TEST_CASE("The LED blinks the faster the worse the air", "[hardware-blinking-display]") {
+  FakeLedTimer ledTimer;
+  HardwareBlinkingDisplay display(&ledTimer);
+  display.setup();
+
+  display.displayCurrentCO2Concentration(800);
+  REQUIRE(ledTimer.plays == 2);
+  REQUIRE(edges(ledTimer, 2100) == std::vector<uint32_t>({ 500, 1000, 1500, 2000 }));
+
+  display.displayCurrentCO2Concentration(1500);
+  REQUIRE(ledTimer.plays == 3);
+  REQUIRE(edges(ledTimer, 1100) == std::vector<uint32_t>({ 250, 500, 750, 1000 }));
+
+  // critical air blinks like bad air
+  display.displayCurrentCO2Concentration(3000);
+  REQUIRE(ledTimer.plays == 3);
+
+  display.displayCurrentCO2Concentration(400);
+  REQUIRE(ledTimer.plays == 4);
+  REQUIRE(edges(ledTimer, 2100) == std::vector<uint32_t>({ 1000, 2000 }));
+}
+
+TEST_CASE("The timer is only reprogrammed when the air quality category changes", "[hardware-blinking-display]") {
+  FakeLedTimer ledTimer;
+  HardwareBlinkingDisplay display(&ledTimer);
+  display.setup();
+
+  // very good and good air blink alike
+  display.displayCurrentCO2Concentration(420);
+  display.displayCurrentCO2Concentration(600);
+  REQUIRE(ledTimer.plays == 1);
+
+  display.displayCurrentCO2Concentration(750);
+  display.displayCurrentCO2Concentration(900);
+  display.displayCurrentCO2Concentration(990);
+  REQUIRE(ledTimer.plays == 2);
+}
+
+TEST_CASE("The LED blinks the error code in bursts", "[hardware-blinking-display]") {
+  FakeLedTimer ledTimer;
+  HardwareBlinkingDisplay display(&ledTimer);
+  display.setup();
+
+  display.displayError(ErrorCode::TX_FAILED);
+  REQUIRE(ledTimer.plays == 2);
+
+  // three blinks of 125 ms, then a second and 125 ms of darkness
+  uint32_t burst = 3 * 250 + 1000;
+  REQUIRE(ledTimer.isOn(0));
+  REQUIRE(edges(ledTimer, 2 * burst + 1) == std::vector<uint32_t>({
+    125, 250, 375, 500, 625,
+    burst, burst + 125, burst + 250, burst + 375, burst + 500, burst + 625,
+    2 * burst }));
+
+  // the error stays on display
+  display.displayCurrentCO2Concentration(1500);
+  display.displayError(ErrorCode::TX_FAILED);
+  REQUIRE(ledTimer.plays == 2);
+
+  display.displayError(ErrorCode::CLAIR_SETUP_FAILED);
+  REQUIRE(ledTimer.plays == 3);
+  REQUIRE(edges(ledTimer, 1251) == std::vector<uint32_t>({ 125, 1250 }));
+}
@@ -0,0 +1,176 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "retained_state.h"
+#include "clair.h"
+#include "clairchen_config.h"
+#include "ram_log_storage.h"
+
+typedef struct {
+  uint32_t counter;
+  uint8_t bytes[7];
+} test_state_t;
+
+// like RAM after a power-on reset, as far as a test can tell
+static RetainedState<test_state_t> zeroed;
+
+TEST_CASE("Retained state is only valid once sealed and as long as it is unchanged", "[retained-state]") {
+  REQUIRE_FALSE(zeroed.isValid());
+
+  RetainedState<test_state_t> state;
+  memset(static_cast<void *>(&state), 0xA5, sizeof(state));
+  REQUIRE_FALSE(state.isValid());
+
+  state.value.counter = 42;
+  state.seal();
+  REQUIRE(state.isValid());
+
+  // a copy, like the RAM contents after a warm reset
+  RetainedState<test_state_t> copy;
+  memcpy(static_cast<void *>(&copy), static_cast<const void *>(&state), sizeof(state));
+  REQUIRE(copy.isValid());
+  REQUIRE(copy.value.counter == 42);
+
+  // a brownout flipped a bit
+  copy.value.bytes[3] ^= 0x10;
+  REQUIRE_FALSE(copy.isValid());
+
+  state.value.counter += 1;
+  REQUIRE_FALSE(state.isValid());
+  state.seal();
+  REQUIRE(state.isValid());
+
+  state.invalidate();
+  REQUIRE_FALSE(state.isValid());
+}
+
+// the textbook form, which reduces the sums after every byte
+static uint16_t bytewiseFletcher16(const uint8_t *data, size_t size) {
+  uint16_t sum1 = 0;
+  uint16_t sum2 = 0;
+  for (size_t i = 0; i < size; i++) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return sum2 << 8 | sum1;
+}
+
+TEST_CASE("The checksum reduces its sums in blocks but equals the bytewise Fletcher-16", "[retained-state]") {
+  static uint8_t data[20000];
+  memset(data, 0xFF, sizeof(data));
+  REQUIRE(fletcher16(data, sizeof(data)) == bytewiseFletcher16(data, sizeof(data)));
+
+  for (size_t i = 0; i < sizeof(data); i++) data[i] = i * 131 + (i >> 7);
+  REQUIRE(fletcher16(data, sizeof(data)) == bytewiseFletcher16(data, sizeof(data)));
+  REQUIRE(fletcher16(data, 1) == bytewiseFletcher16(data, 1));
+  REQUIRE(fletcher16(data, 0) == 0);
+
+  // in ranges
+  uint16_t sum = fletcher16(data, 1000);
+  REQUIRE(fletcher16(data + 1000, sizeof(data) - 1000, sum) == bytewiseFletcher16(data, sizeof(data)));
+}
+
+class RampSensor final : public Sensor {
+  public:
+    uint16_t co2ppm = 400;
+
+    bool setup() override { return true; }
+    bool measurementFailed() override { return false; }
+    clair_sample_t sampleMeasurements() override {
+      co2ppm += 7;
+      clair_sample_t sample = { co2ppm, 2000, 4000 };
+      return sample;
+    }
+};
+
+typedef Clair<RampSensor, ClairchenConfig> TestClair;
+
+static void measure(TestClair &clair, uint32_t seconds) {
+  uint32_t elapsed = 0;
+  while (elapsed < seconds) {
+    elapsed += clair.getSecondsUntilNextMeasurement();
+    REQUIRE(clair.getCO2Concentration() >= 0);
+  }
+}
+
+TEST_CASE("After a warm reset, Clair continues its sampling period and keeps its queued samples", "[retained-state]") {
+  RampSensor sensor;
+  TestClair clair(&sensor);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(0);
+  uint16_t period = clair.getTransmissionConfig().samplingPeriodSeconds;
+
+  // the queue holds a sample, and the next one is half done
+  measure(clair, period + period / 2);
+  REQUIRE_FALSE(clair.isMessageDue());
+
+  static RetainedState<TestClair::State> retained;
+  clair.saveState(&retained.value);
+  retained.seal();
+
+  RampSensor restartedSensor;
+  restartedSensor.co2ppm = sensor.co2ppm;
+  TestClair restarted(&restartedSensor);
+  REQUIRE(restarted.setup());
+  REQUIRE(retained.isValid());
+  restarted.restoreState(retained.value);
+  restarted.setCurrentDatarate(0);
+  REQUIRE(restarted.getTransmissionConfig().samplingPeriodSeconds == period);
+
+  // both nodes complete the period at the same time and send the same message
+  uint8_t samplesPerMessage = clair.getTransmissionConfig().samplesPerMessage;
+  measure(clair, period * samplesPerMessage - period - period / 2);
+  measure(restarted, period * samplesPerMessage - period - period / 2);
+  REQUIRE(clair.isMessageDue());
+  REQUIRE(restarted.isMessageDue());
+
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  uint8_t restartedMessage[TestClair::MAX_MESSAGE_SIZE];
+  uint8_t length = clair.encodeMessage(message, sizeof(message));
+  REQUIRE(length > 0);
+  REQUIRE(restarted.encodeMessage(restartedMessage, sizeof(restartedMessage)) == length);
+  REQUIRE(memcmp(message, restartedMessage, length) == 0);
+}
+
+TEST_CASE("After a warm reset, Clair backfills the samples it logged before", "[retained-state]") {
+  RamLogStorage storage(256, 8);
+  SampleLog sampleLog(&storage);
+  REQUIRE(sampleLog.begin());
+  RampSensor sensor;
+  TestClair clair(&sensor, &sampleLog);
+  REQUIRE(clair.setup());
+  clair.setCurrentDatarate(0);
+
+  // nothing is sent, e.g., because the gateway is down, until samples overflow into the log
+  while (sampleLog.size() < 3) measure(clair, 60);
+
+  static RetainedState<TestClair::State> retained;
+  clair.saveState(&retained.value);
+  retained.seal();
+
+  SampleLog restartedLog(&storage);
+  REQUIRE(restartedLog.begin());
+  RampSensor restartedSensor;
+  restartedSensor.co2ppm = sensor.co2ppm;
+  TestClair restarted(&restartedSensor, &restartedLog);
+  REQUIRE(restarted.setup());
+  REQUIRE(retained.isValid());
+  restarted.restoreState(retained.value);
+  REQUIRE(restartedLog.size() == sampleLog.size());
+
+  // once the gateway is back, the queue drains, and the logged samples follow
+  restarted.setCurrentDatarate(5);
+  uint8_t message[TestClair::MAX_MESSAGE_SIZE];
+  bool backfilled = false;
+  for (uint32_t seconds = 0; !backfilled; seconds += 60) {
+    REQUIRE(seconds < 24 * 3600);
+    measure(restarted, 60);
+    if (!restarted.isMessageDue()) continue;
+
+    uint8_t length = restarted.encodeMessage(message, sizeof(message));
+    REQUIRE(length > 0);
+    restarted.commitMessage();
+    backfilled = ((message[0] >> 3) & 0x7) == CLAIR_MESSAGE_ID_BACKFILL_LIST;
+  }
+  REQUIRE(restartedLog.size() < sampleLog.size());
+}
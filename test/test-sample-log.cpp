@@ -0,0 +1,133 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "sample_log.h"
+#include "ram_log_storage.h"
+
+// 4 records per block
+#define BLOCK_SIZE 32
+#define NROF_BLOCKS 4
+
+static bool appendSample(SampleLog &log, uint32_t time) {
+  uint8_t sample[SAMPLE_LOG_SAMPLE_SIZE] = { static_cast<uint8_t>(time), static_cast<uint8_t>(time >> 8) };
+  return log.append(time, sample);
+}
+
+static uint32_t timeAt(SampleLog &log, uint16_t position) {
+  sample_log_record_t record;
+  REQUIRE(log.read(position, &record));
+  REQUIRE(record.sample[0] == static_cast<uint8_t>(record.time));
+  return record.time;
+}
+
+TEST_CASE("The sample log returns its records oldest first", "[sample-log]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SampleLog log(&storage);
+  REQUIRE(log.begin());
+  REQUIRE(log.size() == 0);
+  REQUIRE(log.capacity() == 12);
+
+  for (uint32_t time = 60; time <= 300; time += 60) REQUIRE(appendSample(log, time));
+  REQUIRE(log.size() == 5);
+  REQUIRE(timeAt(log, 0) == 60);
+  REQUIRE(timeAt(log, 4) == 300);
+
+  sample_log_record_t record;
+  REQUIRE_FALSE(log.read(5, &record));
+
+  log.discardOldest(2);
+  REQUIRE(log.size() == 3);
+  REQUIRE(timeAt(log, 0) == 180);
+}
+
+TEST_CASE("A full sample log drops its oldest block and wears all blocks evenly", "[sample-log]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SampleLog log(&storage);
+  REQUIRE(log.begin());
+
+  for (uint32_t time = 1; time <= 400; time++) REQUIRE(appendSample(log, time));
+  REQUIRE(log.size() >= log.capacity());
+  REQUIRE(timeAt(log, log.size() - 1) == 400);
+  REQUIRE(timeAt(log, 0) == static_cast<uint32_t>(400 - log.size() + 1));
+
+  for (uint16_t block = 0; block < NROF_BLOCKS; block++) {
+    REQUIRE(storage.erases[block] == 25);
+  }
+}
+
+TEST_CASE("The sample log continues after its newest record when restarted", "[sample-log]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  {
+    SampleLog log(&storage);
+    REQUIRE(log.begin());
+    for (uint32_t time = 1; time <= 21; time++) REQUIRE(appendSample(log, time));
+  }
+
+  SampleLog log(&storage);
+  REQUIRE(log.begin());
+  // the caller decides whether the records of the previous start-up still apply
+  REQUIRE(log.size() == 0);
+
+  // record 21 went to slot 4 of 16, so the next one follows in the same block without an erase
+  std::vector<uint32_t> erases = storage.erases;
+  REQUIRE(appendSample(log, 1000));
+  REQUIRE(storage.erases == erases);
+  REQUIRE(log.size() == 1);
+  REQUIRE(timeAt(log, 0) == 1000);
+
+  // the sequence numbers go on, so a further restart finds the new record
+  SampleLog restarted(&storage);
+  REQUIRE(restarted.begin());
+  REQUIRE(appendSample(restarted, 2000));
+  sample_log_record_t newest;
+  sample_log_record_t previous;
+  REQUIRE(restarted.read(0, &newest));
+  REQUIRE(log.read(0, &previous));
+  REQUIRE(newest.sequenceNumber == previous.sequenceNumber + 1);
+}
+
+TEST_CASE("The sample log takes over the newest records of the previous start-up", "[sample-log]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  {
+    SampleLog log(&storage);
+    REQUIRE(log.begin());
+    for (uint32_t time = 1; time <= 21; time++) REQUIRE(appendSample(log, time));
+  }
+
+  SampleLog log(&storage);
+  REQUIRE(log.begin());
+  log.keepNewest(5);
+  REQUIRE(log.size() == 5);
+  REQUIRE(timeAt(log, 0) == 17);
+  REQUIRE(timeAt(log, 4) == 21);
+
+  REQUIRE(appendSample(log, 22));
+  REQUIRE(log.size() == 6);
+  REQUIRE(timeAt(log, 5) == 22);
+
+  // the storage holds no more than the records of the last 4 blocks, some of which were reused
+  SampleLog restarted(&storage);
+  REQUIRE(restarted.begin());
+  restarted.keepNewest(1000);
+  REQUIRE(restarted.size() == 14);
+  REQUIRE(timeAt(restarted, 0) == 9);
+  REQUIRE(timeAt(restarted, 13) == 22);
+}
+
+TEST_CASE("The sample log stops recording when the storage fails", "[sample-log]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SampleLog log(&storage);
+  REQUIRE(log.begin());
+  REQUIRE(appendSample(log, 60));
+
+  storage.failing = true;
+  REQUIRE_FALSE(appendSample(log, 120));
+  storage.failing = false;
+  REQUIRE_FALSE(appendSample(log, 180));
+
+  storage.failing = true;
+  SampleLog broken(&storage);
+  REQUIRE_FALSE(broken.begin());
+  REQUIRE_FALSE(appendSample(broken, 60));
+  REQUIRE(broken.size() == 0);
+}
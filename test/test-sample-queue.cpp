@@ -0,0 +1,78 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "sample_queue.h"
+
+static clair_sample_t sample(uint16_t co2ppm) {
+  clair_sample_t sample;
+  sample.co2ppm = co2ppm;
+  sample.temperatureCentiDegrees = 2000;
+  sample.humidityCentiPercent = 4000;
+  return sample;
+}
+
+TEST_CASE("The sample queue keeps samples oldest first", "[sample-queue]") {
+  SampleQueue<4> queue;
+  REQUIRE(queue.size() == 0);
+
+  REQUIRE(queue.push(sample(400), 400, 60));
+  REQUIRE(queue.push(sample(420), 420, 60));
+  REQUIRE(queue.push(sample(440), 440, 60));
+  REQUIRE(queue.size() == 3);
+  REQUIRE(queue.at(0).co2ppm == 400);
+  REQUIRE(queue.at(2).co2ppm == 440);
+  REQUIRE(queue.timeAt(2) == 440);
+
+  queue.discardOldest(2);
+  REQUIRE(queue.size() == 1);
+  REQUIRE(queue.at(0).co2ppm == 440);
+}
+
+TEST_CASE("A full sample queue discards the oldest sample", "[sample-queue]") {
+  SampleQueue<4> queue;
+  for (uint16_t i = 0; i < 4; i++) REQUIRE(queue.push(sample(400 + i), 400 + i, 60));
+
+  REQUIRE_FALSE(queue.push(sample(404), 404, 60));
+  REQUIRE_FALSE(queue.push(sample(405), 405, 60));
+  REQUIRE(queue.size() == 4);
+  REQUIRE(queue.at(0).co2ppm == 402);
+  REQUIRE(queue.timeAt(0) == 402);
+  REQUIRE(queue.at(3).co2ppm == 405);
+}
+
+TEST_CASE("The oldest samples are copied across the end of the ring", "[sample-queue]") {
+  SampleQueue<4> queue;
+  for (uint16_t i = 0; i < 6; i++) queue.push(sample(400 + i), 400 + i, 60);
+
+  clair_sample_t buffer[3];
+  REQUIRE(queue.copyOldest(buffer, 3) == 3);
+  REQUIRE(buffer[0].co2ppm == 402);
+  REQUIRE(buffer[1].co2ppm == 403);
+  REQUIRE(buffer[2].co2ppm == 404);
+
+  queue.discardOldest(3);
+  REQUIRE(queue.copyOldest(buffer, 3) == 1);
+  REQUIRE(buffer[0].co2ppm == 405);
+
+  queue.discardOldest(5);
+  REQUIRE(queue.size() == 0);
+}
+
+TEST_CASE("The sample queue tells how many of the oldest samples are equispaced", "[sample-queue]") {
+  SampleQueue<4> queue;
+  REQUIRE(queue.countEquispaced() == 0);
+
+  queue.push(sample(400), 60, 60);
+  queue.push(sample(401), 120, 60);
+  REQUIRE(queue.countEquispaced() == 2);
+
+  // the sampling period changed
+  queue.push(sample(402), 240, 120);
+  queue.push(sample(403), 360, 120);
+  REQUIRE(queue.countEquispaced() == 2);
+  REQUIRE(queue.samplingPeriodAt(2) == 120);
+
+  queue.discardOldest(2);
+  REQUIRE(queue.countEquispaced() == 2);
+  REQUIRE(queue.samplingPeriodAt(0) == 120);
+}
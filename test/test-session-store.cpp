@@ -0,0 +1,187 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "session_store.h"
+#include "ram_log_storage.h"
+#include <string.h>
+
+// one checkpoint per block
+#define BLOCK_SIZE 256
+#define NROF_BLOCKS 4
+
+static lorawan_session_t makeSession(uint32_t seqnoUp) {
+  lorawan_session_t session;
+  memset(&session, 0, sizeof(session));
+  session.netid = 0x13;
+  session.devaddr = 0x260B1234;
+  for (uint8_t i = 0; i < 16; i++) {
+    session.nwkKey[i] = i;
+    session.artKey[i] = 0xF0 | i;
+  }
+  session.seqnoUp = seqnoUp;
+  session.datarate = 5;
+  session.adrTxPow = 14;
+  session.channelMap = 0x07;
+  session.channelFreq[0] = 868100000;
+  session.channelDrMap[0] = 0x3F;
+  return session;
+}
+
+static uint32_t totalErases(const RamLogStorage &storage) {
+  uint32_t total = 0;
+  for (size_t i = 0; i < storage.erases.size(); i++) total += storage.erases[i];
+  return total;
+}
+
+TEST_CASE("A restored session continues ahead of any uplink counter used before", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  {
+    SessionStore store(&storage);
+    REQUIRE(store.begin());
+    lorawan_session_t session;
+    REQUIRE_FALSE(store.restore(&session));
+    REQUIRE(store.checkpoint(makeSession(10)));
+  }
+
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+  lorawan_session_t session;
+  REQUIRE(store.restore(&session));
+  REQUIRE(session.devaddr == 0x260B1234);
+  REQUIRE(memcmp(session.artKey, makeSession(0).artKey, sizeof(session.artKey)) == 0);
+  REQUIRE(session.channelFreq[0] == 868100000);
+  REQUIRE(session.seqnoUp == 10 + SESSION_STORE_SEQNO_UP_INTERVAL);
+
+  // a reset right after restoring skips ahead again
+  SessionStore restarted(&storage);
+  REQUIRE(restarted.begin());
+  REQUIRE(restarted.restore(&session));
+  REQUIRE(session.seqnoUp == 10 + 2 * SESSION_STORE_SEQNO_UP_INTERVAL);
+}
+
+TEST_CASE("The session is only checkpointed when it changes or the uplink counter advances far", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+
+  REQUIRE(store.checkpoint(makeSession(0)));
+  REQUIRE(totalErases(storage) == 1);
+
+  for (uint32_t seqnoUp = 1; seqnoUp < SESSION_STORE_SEQNO_UP_INTERVAL; seqnoUp++) {
+    REQUIRE(store.checkpoint(makeSession(seqnoUp)));
+  }
+  REQUIRE(totalErases(storage) == 1);
+
+  REQUIRE(store.checkpoint(makeSession(SESSION_STORE_SEQNO_UP_INTERVAL)));
+  REQUIRE(totalErases(storage) == 2);
+
+  lorawan_session_t changed = makeSession(SESSION_STORE_SEQNO_UP_INTERVAL + 1);
+  changed.datarate = 3;
+  REQUIRE(store.checkpoint(changed));
+  REQUIRE(totalErases(storage) == 3);
+
+  SessionStore restarted(&storage);
+  REQUIRE(restarted.begin());
+  lorawan_session_t session;
+  REQUIRE(restarted.restore(&session));
+  REQUIRE(session.datarate == 3);
+  REQUIRE(session.seqnoUp == 2 * SESSION_STORE_SEQNO_UP_INTERVAL + 1);
+}
+
+TEST_CASE("Checkpoints wear all blocks evenly", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+
+  for (uint32_t i = 0; i < 40; i++) {
+    REQUIRE(store.checkpoint(makeSession(i * SESSION_STORE_SEQNO_UP_INTERVAL)));
+  }
+  for (uint16_t block = 0; block < NROF_BLOCKS; block++) {
+    REQUIRE(storage.erases[block] == 10);
+  }
+
+  SessionStore restarted(&storage);
+  REQUIRE(restarted.begin());
+  lorawan_session_t session;
+  REQUIRE(restarted.restore(&session));
+  REQUIRE(session.seqnoUp == 40 * SESSION_STORE_SEQNO_UP_INTERVAL);
+}
+
+TEST_CASE("A torn checkpoint is ignored in favour of the previous one", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  {
+    SessionStore store(&storage);
+    REQUIRE(store.begin());
+    REQUIRE(store.checkpoint(makeSession(0)));
+  }
+
+  // power failed while the next checkpoint was written: only its start made it to the storage
+  uint8_t bytes[8];
+  REQUIRE(storage.read(0, bytes, sizeof(bytes)));
+  bytes[0] += 1;
+  REQUIRE(storage.write(BLOCK_SIZE, bytes, sizeof(bytes)));
+
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+  lorawan_session_t session;
+  REQUIRE(store.restore(&session));
+  REQUIRE(session.seqnoUp == SESSION_STORE_SEQNO_UP_INTERVAL);
+}
+
+TEST_CASE("A cleared session store has no session to restore", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+  REQUIRE(store.checkpoint(makeSession(100)));
+
+  REQUIRE(store.clear());
+  lorawan_session_t session;
+  REQUIRE_FALSE(store.restore(&session));
+
+  SessionStore restarted(&storage);
+  REQUIRE(restarted.begin());
+  REQUIRE_FALSE(restarted.restore(&session));
+}
+
+TEST_CASE("A session without a device address is not restored", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+
+  // as checkpointed before the first join
+  lorawan_session_t unjoined;
+  memset(&unjoined, 0, sizeof(unjoined));
+  REQUIRE(store.checkpoint(unjoined));
+  lorawan_session_t session;
+  REQUIRE_FALSE(store.restore(&session));
+
+  SessionStore restarted(&storage);
+  REQUIRE(restarted.begin());
+  REQUIRE_FALSE(restarted.restore(&session));
+
+  // a join then checkpoints a session that is restored
+  REQUIRE(restarted.checkpoint(makeSession(0)));
+  REQUIRE(restarted.restore(&session));
+  REQUIRE(session.devaddr == 0x260B1234);
+}
+
+TEST_CASE("The session store gives up when the storage fails", "[session-store]") {
+  RamLogStorage storage(BLOCK_SIZE, NROF_BLOCKS);
+  SessionStore store(&storage);
+  REQUIRE(store.begin());
+
+  storage.failing = true;
+  REQUIRE_FALSE(store.checkpoint(makeSession(0)));
+  lorawan_session_t session;
+  REQUIRE_FALSE(store.restore(&session));
+
+  SessionStore broken(&storage);
+  REQUIRE(broken.begin());
+  REQUIRE_FALSE(broken.restore(&session));
+  REQUIRE_FALSE(broken.checkpoint(makeSession(0)));
+
+  RamLogStorage tooSmall(BLOCK_SIZE, 1);
+  SessionStore unusable(&tooSmall);
+  REQUIRE_FALSE(unusable.begin());
+  REQUIRE_FALSE(unusable.checkpoint(makeSession(0)));
+}
@@ -0,0 +1,64 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "sim/sim.h"
+#include "airtime.h"
+#include "clair.h"
+
+// the firmware keeps its state in statics, so the whole week is one test run
+TEST_CASE("A week of the firmware event loop respects the TTN fair use policy", "[simulation]") {
+  sim::options_t options;
+  options.datarate = -1;
+  options.adrWalk = false;
+  options.seed = 1;
+  options.verbose = false;
+  options.devEui = 0;
+  options.pollRadio = false;
+  // no uplinks on Tuesday from 6:00 to 18:00, e.g., because the gateway is down
+  options.outageStartSecs = (24 + 6) * 3600;
+  options.outageSecs = 12 * 3600;
+
+  sim::configure(options);
+  sim::runUntil(SIM_DAYS(7));
+
+  REQUIRE(sim::uplinks().size() > 0);
+  REQUIRE(sim::transmittedSamples() > 0);
+  REQUIRE(sim::transmittedSamples() <= sim::coveredSamplingPeriods());
+  REQUIRE(sim::maxAirtimeInWindowUs(SIM_DAYS(1)) <= AIRTIME_TTN_BUDGET_US_PER_DAY);
+
+  // messages are only handed to LMIC when the duty cycle lets it send them right away
+  for (size_t i = 0; i < sim::uplinks().size(); i++) {
+    REQUIRE(sim::uplinks()[i].timeUs - sim::uplinks()[i].queuedUs < SIM_SECONDS(1));
+  }
+
+  // LMIC stamps the end of each uplink in the DIO interrupt, and measurements keep clear of the receive windows
+  REQUIRE(sim::counters().missedRxWindows == 0);
+
+  // the LED blinks off a timer, which is only reprogrammed when the air quality changes, so the CPU wakes up for little more than measurements
+  REQUIRE(sim::counters().ledToggles == 0);
+  REQUIRE(sim::counters().ledPatterns < sim::counters().sensorReads / 50);
+  REQUIRE(sim::counters().wakeups < sim::counters().sensorReads * 11 / 10);
+
+  // between its jobs, the CPU sleeps in standby
+  REQUIRE(sim::counters().asleepUs > SIM_DAYS(7) * 99 / 100);
+
+  // once the network has told the time, samples end on multiples of their sampling period in UTC
+  REQUIRE(sim::alignedSamples() >= sim::sampleListSamples() * 9 / 10);
+
+  // the samples of the outage that did not fit into the sample queue have been logged and sent later
+  REQUIRE(sim::backfilledSamples() > 0);
+
+  // the office changes air quality and airs several times a day, at most every 15 minutes
+  uint64_t alerts = 0;
+  for (size_t i = 0; i < sim::uplinks().size(); i++) {
+    if (((sim::uplinks()[i].payload[0] >> 3) & 0x7) == CLAIR_MESSAGE_ID_ALERT) alerts += 1;
+  }
+  REQUIRE(alerts >= 5 * 4);
+  REQUIRE(alerts <= 7 * 24 * 4);
+
+#if CLAIR_WINDOWED_SAMPLING && !CLAIR_SWINGING_DOOR_DEVIATION_PPM
+  // each sample averages MEASUREMENTS_PER_SAMPLE measurements spread over its whole sampling period,
+  // plus some slack for replanning
+  REQUIRE(sim::counters().sensorReads <= 13 * sim::coveredSamplingPeriods());
+#endif
+}
@@ -0,0 +1,81 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "swinging_door.h"
+
+static clair_sample_t reading(uint16_t co2ppm) {
+  clair_sample_t sample;
+  sample.co2ppm = co2ppm;
+  sample.temperatureCentiDegrees = 2000;
+  sample.humidityCentiPercent = 4000;
+  return sample;
+}
+
+TEST_CASE("The first reading is a breakpoint", "[swinging-door]") {
+  SwingingDoor door(20, 1275);
+  clair_sample_t breakpoint;
+  uint32_t time;
+
+  REQUIRE(door.add(5, reading(420), &breakpoint, &time));
+  REQUIRE(breakpoint.co2ppm == 420);
+  REQUIRE(time == 5);
+  REQUIRE_FALSE(door.hasPendingReadings());
+}
+
+TEST_CASE("Readings within the deviation are approximated by a line", "[swinging-door]") {
+  SwingingDoor door(20, 1275);
+  clair_sample_t breakpoint;
+  uint32_t time;
+
+  door.add(0, reading(400), &breakpoint, &time);
+  // noise around a slow rise of 1 ppm per 5 s
+  uint16_t noise[] = { 0, 15, 0, 10, 19, 5, 0, 12 };
+  for (uint32_t i = 1; i < 100; i++) {
+    REQUIRE_FALSE(door.add(5 * i, reading(400 + i + noise[i % 8]), &breakpoint, &time));
+  }
+  REQUIRE(door.hasPendingReadings());
+
+  REQUIRE(door.flush(&breakpoint, &time));
+  REQUIRE(time == 495);
+  REQUIRE_FALSE(door.hasPendingReadings());
+  REQUIRE_FALSE(door.flush(&breakpoint, &time));
+}
+
+TEST_CASE("A sharp change closes the door at the last reading before it", "[swinging-door]") {
+  SwingingDoor door(20, 1275);
+  clair_sample_t breakpoint;
+  uint32_t time;
+
+  door.add(0, reading(400), &breakpoint, &time);
+  for (uint32_t t = 5; t <= 600; t += 5) {
+    REQUIRE_FALSE(door.add(t, reading(400), &breakpoint, &time));
+  }
+
+  REQUIRE(door.add(605, reading(500), &breakpoint, &time));
+  REQUIRE(breakpoint.co2ppm == 400);
+  REQUIRE(time == 600);
+
+  // the jump is followed by a steady rise
+  REQUIRE(door.add(610, reading(520), &breakpoint, &time));
+  REQUIRE(breakpoint.co2ppm == 500);
+  REQUIRE(time == 605);
+  for (uint32_t t = 615; t <= 700; t += 5) {
+    REQUIRE_FALSE(door.add(t, reading(500 + (t - 605) * 4), &breakpoint, &time));
+  }
+  REQUIRE(door.add(705, reading(820), &breakpoint, &time));
+  REQUIRE(breakpoint.co2ppm == 880);
+  REQUIRE(time == 700);
+}
+
+TEST_CASE("A breakpoint is archived when the door is open too long", "[swinging-door]") {
+  SwingingDoor door(20, 100);
+  clair_sample_t breakpoint;
+  uint32_t time;
+
+  door.add(0, reading(400), &breakpoint, &time);
+  for (uint32_t t = 5; t <= 100; t += 5) {
+    REQUIRE_FALSE(door.add(t, reading(400), &breakpoint, &time));
+  }
+  REQUIRE(door.add(105, reading(400), &breakpoint, &time));
+  REQUIRE(time == 100);
+}
@@ -0,0 +1,160 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "timer_service.h"
+#include <vector>
+
+/* a minimal LMIC scheduler, in ticks */
+
+static ostime_t now;
+static std::vector<osjob_t *> jobs;
+static int wakeups;
+
+ostime_t os_getTime() {
+  return now;
+}
+
+void os_clearCallback(osjob_t *job) {
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (jobs[i] == job) {
+      jobs.erase(jobs.begin() + i);
+      return;
+    }
+  }
+}
+
+void os_setTimedCallback(osjob_t *job, ostime_t time, osjobcb_t cb) {
+  os_clearCallback(job);
+  job->deadline = time;
+  job->func = cb;
+  jobs.push_back(job);
+}
+
+static osjob_t *nextJob() {
+  osjob_t *next = NULL;
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (next == NULL || static_cast<int32_t>(jobs[i]->deadline - next->deadline) < 0) next = jobs[i];
+  }
+  return next;
+}
+
+ostime_t os_getNextDeadline(bit_t *pfDeadlineValid) {
+  osjob_t *next = nextJob();
+  *pfDeadlineValid = next != NULL;
+  return next != NULL ? next->deadline : now;
+}
+
+static void runUntil(ostime_t end) {
+  for (osjob_t *job = nextJob(); job != NULL && static_cast<int32_t>(end - job->deadline) >= 0; job = nextJob()) {
+    if (static_cast<int32_t>(job->deadline - now) > 0) {
+      now = job->deadline;
+      wakeups += 1;
+    }
+    os_clearCallback(job);
+    job->func(job);
+  }
+  now = end;
+}
+
+static void reset(ostime_t start) {
+  now = start;
+  jobs.clear();
+  wakeups = 0;
+}
+
+struct Recorder {
+  std::vector<ostime_t> times;
+};
+
+static void record(void *context) {
+  static_cast<Recorder *>(context)->times.push_back(os_getTime());
+}
+
+TEST_CASE("Timers call back with their context", "[timer service]") {
+  reset(0);
+  TimerService timers;
+  Recorder first, second;
+  Timer firstTimer(record, &first);
+  Timer secondTimer(record, &second);
+
+  timers.schedule(&firstTimer, 100);
+  timers.schedule(&secondTimer, 50);
+  REQUIRE(timers.isPending(&firstTimer));
+  runUntil(1000);
+
+  REQUIRE(first.times == std::vector<ostime_t>{100});
+  REQUIRE(second.times == std::vector<ostime_t>{50});
+  REQUIRE_FALSE(timers.isPending(&firstTimer));
+  REQUIRE(wakeups == 2);
+}
+
+TEST_CASE("Timers within each other's tolerance share a wakeup", "[timer service]") {
+  reset(0);
+  TimerService timers;
+  Recorder early, late, apart;
+  Timer earlyTimer(record, &early);
+  Timer lateTimer(record, &late);
+  Timer apartTimer(record, &apart);
+
+  timers.schedule(&earlyTimer, 100, 50);
+  timers.schedule(&lateTimer, 130, 100);
+  // beyond the tolerance of the early timer
+  timers.schedule(&apartTimer, 200, 100);
+  runUntil(1000);
+
+  // as early as possible for both
+  REQUIRE(early.times == std::vector<ostime_t>{130});
+  REQUIRE(late.times == std::vector<ostime_t>{130});
+  REQUIRE(apart.times == std::vector<ostime_t>{200});
+  REQUIRE(wakeups == 2);
+}
+
+TEST_CASE("Timers share the wakeup of an LMIC job within their tolerance", "[timer service]") {
+  reset(0);
+  TimerService timers;
+  Recorder recorder;
+  Timer timer(record, &recorder);
+  osjob_t lmicJob;
+  os_setTimedCallback(&lmicJob, 120, [](osjob_t *) {});
+
+  timers.schedule(&timer, 100, 50);
+  runUntil(1000);
+
+  REQUIRE(recorder.times == std::vector<ostime_t>{120});
+  REQUIRE(wakeups == 1);
+}
+
+TEST_CASE("Timers can be moved, cancelled, and rescheduled from their callback", "[timer service]") {
+  reset(-1000); // across the wrap-around of ostime_t
+  TimerService timers;
+  Recorder moved, cancelled;
+  Timer movedTimer(record, &moved);
+  Timer cancelledTimer(record, &cancelled);
+
+  timers.schedule(&movedTimer, -900);
+  timers.schedule(&cancelledTimer, -800);
+  timers.schedule(&movedTimer, 200);
+  timers.cancel(&cancelledTimer);
+  REQUIRE_FALSE(timers.isPending(&cancelledTimer));
+  runUntil(1000);
+
+  REQUIRE(moved.times == std::vector<ostime_t>{200});
+  REQUIRE(cancelled.times.empty());
+
+  struct Periodic {
+    TimerService *timers;
+    Timer timer;
+    int count;
+    Periodic(TimerService *timersArg) : timers(timersArg), timer(tick, this), count(0) {}
+    static void tick(void *context) {
+      Periodic *periodic = static_cast<Periodic *>(context);
+      periodic->count += 1;
+      periodic->timers->schedule(&periodic->timer, os_getTime() + 100);
+    }
+  } periodic(&timers);
+  timers.scheduleNow(&periodic.timer);
+  runUntil(1000 + 1000);
+
+  // at 1000, 1100, ..., 2000
+  REQUIRE(periodic.count == 11);
+}
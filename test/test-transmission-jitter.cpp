@@ -0,0 +1,65 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "transmission_jitter.h"
+#include <string.h>
+
+static const uint8_t DEVEUI[TRANSMISSION_JITTER_DEVEUI_SIZE] = { 0x00, 0x00, 0x1C, 0x00, 0x0B, 0xA3, 0x04, 0x00 };
+
+TEST_CASE("Delays stay below the bound", "[transmission jitter]") {
+  TransmissionJitter jitter;
+  jitter.begin(DEVEUI);
+
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(jitter.delayMillis(60000) < 60000);
+    REQUIRE(jitter.delayMillis(5000) < 5000);
+    REQUIRE(jitter.delayMillis(1) == 0);
+    REQUIRE(jitter.delayMillis(0) == 0);
+  }
+}
+
+TEST_CASE("The phase is fixed, the jitter changes from message to message", "[transmission jitter]") {
+  TransmissionJitter jitter;
+  jitter.begin(DEVEUI);
+  uint32_t boundMillis = 840000;
+  uint32_t phaseMillis = (static_cast<uint64_t>(boundMillis / 2) * jitter.getPhase()) >> 16;
+
+  uint32_t minDelayMillis = UINT32_MAX;
+  uint32_t maxDelayMillis = 0;
+  for (int i = 0; i < 1000; i++) {
+    uint32_t delayMillis = jitter.delayMillis(boundMillis);
+    REQUIRE(delayMillis >= phaseMillis);
+    REQUIRE(delayMillis < phaseMillis + boundMillis / 2);
+    if (delayMillis < minDelayMillis) minDelayMillis = delayMillis;
+    if (delayMillis > maxDelayMillis) maxDelayMillis = delayMillis;
+  }
+  // the jitter covers most of half the bound
+  REQUIRE(maxDelayMillis - minDelayMillis > boundMillis / 2 * 9 / 10);
+
+  // the same DevEUI gives the same delays, e.g., after a reset
+  TransmissionJitter restarted;
+  restarted.begin(DEVEUI);
+  TransmissionJitter again;
+  again.begin(DEVEUI);
+  for (int i = 0; i < 10; i++) {
+    REQUIRE(restarted.delayMillis(boundMillis) == again.delayMillis(boundMillis));
+  }
+}
+
+TEST_CASE("Consecutive DevEUIs get phases spread over the bound", "[transmission jitter]") {
+  // a batch of 64 nodes, each phase in one of 8 bins
+  int bins[8] = { 0 };
+  uint8_t devEui[TRANSMISSION_JITTER_DEVEUI_SIZE];
+  memcpy(devEui, DEVEUI, sizeof(devEui));
+  for (int node = 0; node < 64; node++) {
+    devEui[0] = node;
+    TransmissionJitter jitter;
+    jitter.begin(devEui);
+    bins[jitter.getPhase() >> 13] += 1;
+  }
+
+  for (int i = 0; i < 8; i++) {
+    REQUIRE(bins[i] > 0);
+    REQUIRE(bins[i] < 24);
+  }
+}
@@ -3,6 +3,7 @@
 #include <arduino_lmic.h>
 #include <hal/hal.h>
 #include <Arduino.h>
+#include <string.h>
 
 #include "euis.h"
 
@@ -50,3 +51,77 @@ void resumeConnection() {
   PRINTLN(F("Resuming an already established session."));
   PRINT_ADDRESSES_AND_KEYS();
 }
+
+static_assert(MAX_CHANNELS <= SESSION_STORE_MAX_CHANNELS, "the session store must hold all channels");
+
+bool restoreSession(SessionStore *sessionStore) {
+  lorawan_session_t session;
+  if (!sessionStore->restore(&session)) return false;
+
+  LMIC_setSession(session.netid, session.devaddr, session.nwkKey, session.artKey);
+  LMIC_setSeqnoUp(session.seqnoUp);
+  LMIC.seqnoDn = session.seqnoDn;
+  LMIC.devNonce = session.devNonce;
+  LMIC.adrAckReq = session.adrAckReq;
+  LMIC_setDrTxpow(session.datarate, session.adrTxPow);
+  LMIC.dn2Dr = session.dn2Dr;
+  LMIC.rx1DrOffset = session.rx1DrOffset;
+  LMIC.rxDelay = session.rxDelay;
+
+  // the channel plan may have been changed by the network, so it is restored as it was
+  memcpy(LMIC.channelFreq, session.channelFreq, sizeof(LMIC.channelFreq));
+  memcpy(LMIC.channelDrMap, session.channelDrMap, sizeof(LMIC.channelDrMap));
+  LMIC.channelMap = session.channelMap;
+
+  PRINTLN(F("Restored the session of the last checkpoint."));
+  PRINT(F("Uplink Sequence Counter: ")); PRINTLN(LMIC.seqnoUp);
+  PRINT_ADDRESSES_AND_KEYS();
+  return true;
+}
+
+void checkpointSession(SessionStore *sessionStore) {
+  lorawan_session_t session;
+  memset(&session, 0, sizeof(session));
+
+  LMIC_getSessionKeys(&session.netid, &session.devaddr, session.nwkKey, session.artKey);
+  session.seqnoUp = LMIC.seqnoUp;
+  session.seqnoDn = LMIC.seqnoDn;
+  session.devNonce = LMIC.devNonce;
+  session.adrAckReq = LMIC.adrAckReq;
+  session.datarate = LMIC.datarate;
+  session.adrTxPow = LMIC.adrTxPow;
+  session.dn2Dr = LMIC.dn2Dr;
+  session.rx1DrOffset = LMIC.rx1DrOffset;
+  session.rxDelay = LMIC.rxDelay;
+  memcpy(session.channelFreq, LMIC.channelFreq, sizeof(LMIC.channelFreq));
+  memcpy(session.channelDrMap, LMIC.channelDrMap, sizeof(LMIC.channelDrMap));
+  session.channelMap = LMIC.channelMap;
+
+  if (!sessionStore->checkpoint(session)) {
+    PRINTLN(F("WARNING: session checkpoint failed"));
+  }
+}
+
+// the longest off-time of a band, after a maximum size uplink at SF12 in a 0.1 % band
+#define MAX_BAND_OFF_TIME_MS (3 * 3600 * 1000L)
+
+uint32_t getMillisUntilTxPossible() {
+  ostime_t now = os_getTime();
+  ostime_t earliest = 0;
+  bool found = false;
+
+  for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+    if (!(LMIC.channelMap & (1 << channel)) || !(LMIC.channelDrMap[channel] & (1 << LMIC.datarate))) continue;
+    // the band of a channel is kept in the lowest bits of its frequency
+    ostime_t wait = LMIC.bands[LMIC.channelFreq[channel] & 0x3].avail - now;
+    if (!found || wait < earliest) earliest = wait;
+    found = true;
+  }
+  if (!found) return 0;
+
+  if (LMIC.globalDutyRate != 0 && LMIC.globalDutyAvail - now > earliest) earliest = LMIC.globalDutyAvail - now;
+
+  // a band that has not been used for hours has an availability time that wrapped around into the future
+  if (earliest <= 0 || osticks2ms(earliest) > MAX_BAND_OFF_TIME_MS) return 0;
+  return osticks2ms(earliest);
+}
@@ -1,6 +1,26 @@
 #ifndef THINGS_NETWORK_H
 #define THINGS_NETWORK_H
 
+#include "session_store.h"
+
 void resumeConnection();
 
+/**
+ * Continue the session of the last checkpoint, without joining.
+ *
+ * Returns false if there is no checkpoint of a session with a device address.
+ */
+bool restoreSession(SessionStore *sessionStore);
+
+/**
+ * Checkpoint the current session, e.g., after joining or an uplink.
+ */
+void checkpointSession(SessionStore *sessionStore);
+
+/**
+ * Returns how long the duty cycle of the bands keeps LMIC from sending an
+ * uplink at the current datarate, in milliseconds, 0 if it may send now.
+ */
+uint32_t getMillisUntilTxPossible();
+
 #endif /* THINGS_NETWORK_H */
@@ -0,0 +1,101 @@
+#include "timer_service.h"
+#include <stddef.h>
+
+/* ostime_t wraps around, so times are compared by their difference */
+static bool isBefore(ostime_t time, ostime_t other) {
+  return static_cast<int32_t>(time - other) < 0;
+}
+
+Timer::Timer(timer_callback_t callbackArg, void *contextArg) {
+  callback = callbackArg;
+  context = contextArg;
+  deadline = 0;
+  latest = 0;
+  pending = false;
+  next = NULL;
+}
+
+TimerService::TimerService() {
+  first = NULL;
+}
+
+void TimerService::schedule(Timer *timer, ostime_t deadline, ostime_t toleranceTicks) {
+  unlink(timer);
+  timer->deadline = deadline;
+  timer->latest = deadline + (toleranceTicks > 0 ? toleranceTicks : 0);
+  timer->pending = true;
+
+  // behind timers with the same deadline, so that they fire in the order they were scheduled
+  Timer **link = &first;
+  while (*link != NULL && !isBefore(deadline, (*link)->deadline)) link = &(*link)->next;
+  timer->next = *link;
+  *link = timer;
+
+  reschedule();
+}
+
+void TimerService::scheduleNow(Timer *timer) {
+  schedule(timer, os_getTime());
+}
+
+void TimerService::cancel(Timer *timer) {
+  unlink(timer);
+  reschedule();
+}
+
+bool TimerService::isPending(const Timer *timer) const {
+  return timer->pending;
+}
+
+void TimerService::unlink(Timer *timer) {
+  if (!timer->pending) return;
+
+  for (Timer **link = &first; *link != NULL; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      break;
+    }
+  }
+  timer->pending = false;
+  timer->next = NULL;
+}
+
+void TimerService::reschedule() {
+  // LMIC's next deadline must not be our own
+  os_clearCallback(&job);
+  if (first == NULL) return;
+
+  // no timer may fire later than this
+  ostime_t latest = first->latest;
+  for (Timer *timer = first->next; timer != NULL; timer = timer->next) {
+    if (isBefore(timer->latest, latest)) latest = timer->latest;
+  }
+
+  // as early as possible, but late enough for all timers that are due by then
+  ostime_t wakeup = first->deadline;
+  for (Timer *timer = first->next; timer != NULL && !isBefore(latest, timer->deadline); timer = timer->next) {
+    wakeup = timer->deadline;
+  }
+
+  bit_t lmicDeadlineValid;
+  ostime_t lmicDeadline = os_getNextDeadline(&lmicDeadlineValid);
+  if (lmicDeadlineValid && isBefore(wakeup, lmicDeadline) && !isBefore(latest, lmicDeadline)) {
+    wakeup = lmicDeadline;
+  }
+
+  os_setTimedCallback(&job, wakeup, run);
+}
+
+void TimerService::run(osjob_t *job) {
+  TimerService *service = reinterpret_cast<TimerService *>(job);
+
+  // the callbacks may schedule timers, also this one
+  ostime_t now = os_getTime();
+  while (service->first != NULL && !isBefore(now, service->first->deadline)) {
+    Timer *timer = service->first;
+    service->unlink(timer);
+    timer->callback(timer->context);
+  }
+
+  service->reschedule();
+}
@@ -0,0 +1,73 @@
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <arduino_lmic.h>
+
+typedef void (*timer_callback_t)(void *context);
+
+class TimerService;
+
+/**
+ * A one-shot timer that calls back with a context pointer, e.g., the object
+ * that owns it, unlike LMIC's osjob_t
+ */
+class Timer {
+  public:
+    /**
+     * Constructor
+     */
+    Timer(timer_callback_t callback, void *context);
+
+  private:
+    friend class TimerService;
+
+    timer_callback_t callback;
+    void *context;
+    ostime_t deadline;
+    ostime_t latest; // deadline plus tolerance
+    bool pending;
+    Timer *next;
+};
+
+/**
+ * Runs any number of timers off a single LMIC job.
+ *
+ * Each timer may fire up to a tolerance after its deadline. The service
+ * wakes up at the latest time that keeps every pending timer within its
+ * tolerance, or earlier with LMIC's next job if that falls into the window,
+ * and fires all timers that are due by then, so that jobs whose deadlines are
+ * close share a wakeup of the CPU.
+ */
+class TimerService {
+  public:
+    /**
+     * Constructor
+     */
+    TimerService();
+
+    /**
+     * Fire the timer at the deadline, or up to toleranceTicks later.
+     * Scheduling a pending timer moves it.
+     */
+    void schedule(Timer *timer, ostime_t deadline, ostime_t toleranceTicks = 0);
+
+    /**
+     * Fire the timer as soon as possible.
+     */
+    void scheduleNow(Timer *timer);
+
+    void cancel(Timer *timer);
+
+    bool isPending(const Timer *timer) const;
+
+  private:
+    // first, so that run() finds the service from its job
+    osjob_t job;
+    Timer *first; // sorted by deadline
+
+    void unlink(Timer *timer);
+    void reschedule();
+    static void run(osjob_t *job);
+};
+
+#endif /* TIMER_SERVICE_H */
@@ -0,0 +1,38 @@
+/*
+ * Prints the airtime analysis of docs/sampling-and-transmission-scheme.md
+ * for a given sample and header size, using the firmware's airtime module.
+ *
+ * Usage: airtime-table [SAMPLE_SIZE [HEADER_SIZE [MAX_SAMPLES]]]
+ */
+
+#include "airtime.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *datarateNames[] = { "SF12", "SF11", "SF10", "SF9", "SF8", "SF7", "SF7w" };
+
+int main(int argc, char **argv) {
+  int sampleSize = argc > 1 ? atoi(argv[1]) : 2;
+  int headerSize = argc > 2 ? atoi(argv[2]) : 1;
+  int maxSamples = argc > 3 ? atoi(argv[3]) : 8;
+  if (sampleSize <= 0 || headerSize < 0 || maxSamples <= 0) {
+    fprintf(stderr, "usage: %s [SAMPLE_SIZE [HEADER_SIZE [MAX_SAMPLES]]]\n", argv[0]);
+    return 2;
+  }
+
+  printf("%-5s %8s %9s %12s %13s %9s\n", "MCS", "#samples", "payload", "airtime[ms]", "interval[s]", "period[s]");
+  for (int datarate = 6; datarate >= 0; datarate--) {
+    for (int samples = 1; samples <= maxSamples; samples++) {
+      int payloadSize = headerSize + samples * sampleSize;
+      uint32_t airtime = airtimeOfUplinkUs(datarate, payloadSize);
+      uint32_t interval = airtimeMinTransmissionIntervalSecs(airtime);
+      // only print the largest number of samples of each airtime step
+      uint32_t nextAirtime = airtimeOfUplinkUs(datarate, payloadSize + sampleSize);
+      if (samples < maxSamples && nextAirtime == airtime) continue;
+      printf("%-5s %8d %9d %12.1f %13u %9u\n", datarateNames[datarate], samples, payloadSize, airtime / 1000.0,
+          interval, (interval + samples - 1) / samples);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Decodes Clairchen uplink payloads given as hex strings, as shown in the
+ * TTN console, one per argument or per line on stdin.
+ *
+ * Usage: clair-decode [--step SECS] [HEX_PAYLOAD ...]
+ *
+ * With --step, the series is rebuilt by linear interpolation every SECS
+ * seconds, e.g., from the breakpoints of a breakpoint list.
+ */
+
+#include "clairchen_decoder.h"
+#include "clair_protocol.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static const char *messageNames[] = { "sample list", "delta list", "Rice list", "breakpoint list", "alert", "heartbeat",
+  "backfill list" };
+static const char *airQualityNames[] = { "very good", "good", "fair", "bad", "critical" };
+static const uint8_t NROF_MESSAGE_NAMES = sizeof(messageNames) / sizeof(messageNames[0]);
+
+static uint16_t stepSeconds = 0;
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  c = tolower(c);
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static bool decode(const char *hex) {
+  uint8_t payload[256];
+  uint16_t length = 0;
+  int high = -1;
+  for (const char *c = hex; *c; c++) {
+    if (isspace(*c)) continue;
+    int digit = hexDigit(*c);
+    if (digit < 0 || length == sizeof(payload)) {
+      fprintf(stderr, "invalid payload: %s\n", hex);
+      return false;
+    }
+    if (high < 0) {
+      high = digit;
+    } else {
+      payload[length++] = high << 4 | digit;
+      high = -1;
+    }
+  }
+  if (length == 0) return true;
+
+  decoded_message_t message;
+  if (high >= 0 || !decodeClairchenMessage(payload, length, &message)) {
+    fprintf(stderr, "cannot decode payload: %s\n", hex);
+    return false;
+  }
+
+  printf("version %u, %s, %u samples, sampling period %u s\n", message.version,
+      message.messageId < NROF_MESSAGE_NAMES ? messageNames[message.messageId] : "unknown",
+      message.numberOfSamples, message.samplingPeriodSeconds);
+  if (message.backlogSamples > 0) {
+    printf("  followed by %u sampling periods of queued samples\n", message.backlogSamples);
+  } else if (message.transmissionDelaySeconds > 0) {
+    printf("  sent %u s after its last sample\n", message.transmissionDelaySeconds);
+  }
+  if (message.messageId == CLAIR_MESSAGE_ID_ALERT) {
+    printf("  air quality %s, CO2 trend %d ppm/min\n",
+        message.airQuality < 5 ? airQualityNames[message.airQuality] : "unknown", message.co2TrendPpmPerMinute);
+  }
+
+  decoded_sample_t series[1024];
+  const decoded_sample_t *samples = message.samples;
+  uint16_t numberOfSamples = message.numberOfSamples;
+  if (stepSeconds > 0) {
+    numberOfSamples = reconstructClairchenSeries(&message, stepSeconds, series, sizeof(series) / sizeof(series[0]));
+    samples = series;
+  }
+  for (uint16_t i = 0; i < numberOfSamples; i++) {
+    printf("  -%5u s %4u ppm %3u °C %3u %%\n", samples[i].ageSeconds, samples[i].co2ppm, samples[i].temperature,
+        samples[i].humidity);
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool ok = true;
+
+  int first = 1;
+  if (argc > 2 && strcmp(argv[1], "--step") == 0) {
+    stepSeconds = atoi(argv[2]);
+    first = 3;
+  }
+
+  if (argc > first) {
+    for (int i = first; i < argc; i++) ok = decode(argv[i]) && ok;
+  } else {
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) ok = decode(line) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+#include "clairchen_decoder.h"
+#include "clair_protocol.h"
+
+/* the quantized values of a sample, as transmitted */
+typedef struct {
+  int16_t co2;
+  int16_t temperature;
+  int16_t humidity;
+} quantized_sample_t;
+
+typedef struct {
+  const uint8_t *buffer;
+  uint16_t sizeInBits;
+  uint16_t position;
+} bit_reader_t;
+
+static bool readBits(bit_reader_t *reader, uint8_t width, uint16_t *value) {
+  if (reader->position + width > reader->sizeInBits) return false;
+
+  *value = 0;
+  for (uint8_t i = 0; i < width; i++) {
+    uint8_t bit = (reader->buffer[reader->position / 8] >> (7 - reader->position % 8)) & 1;
+    *value = (*value << 1) | bit;
+    reader->position += 1;
+  }
+  return true;
+}
+
+static bool readSignedBits(bit_reader_t *reader, uint8_t width, int16_t *value) {
+  uint16_t bits;
+  if (!readBits(reader, width, &bits)) return false;
+  // sign extension of the two's complement number
+  *value = width > 0 && (bits & (1 << (width - 1))) ? bits - (1 << width) : bits;
+  return true;
+}
+
+static bool readRiceCode(bit_reader_t *reader, uint8_t parameter, int16_t *value) {
+  uint16_t quotient = 0;
+  uint16_t bit;
+  while (true) {
+    if (!readBits(reader, 1, &bit)) return false;
+    if (bit == 0) break;
+    quotient += 1;
+  }
+  uint16_t remainder;
+  if (!readBits(reader, parameter, &remainder)) return false;
+
+  uint16_t zigzag = (quotient << parameter) | remainder;
+  *value = zigzag & 1 ? -static_cast<int16_t>((zigzag + 1) / 2) : zigzag / 2;
+  return true;
+}
+
+static quantized_sample_t readSample(const uint8_t *buffer) {
+  quantized_sample_t sample;
+  sample.co2 = buffer[0];
+  sample.temperature = buffer[1] >> 3;
+  sample.humidity = buffer[1] & 0x7;
+  return sample;
+}
+
+static decoded_sample_t dequantize(quantized_sample_t sample) {
+  decoded_sample_t decoded;
+  decoded.co2ppm = sample.co2 * 20;
+  decoded.temperature = sample.temperature;
+  decoded.humidity = (sample.humidity + 1) * 10;
+  decoded.ageSeconds = 0;
+  return decoded;
+}
+
+static bool decodeBreakpoints(const uint8_t *payload, uint8_t length, decoded_message_t *message) {
+  const uint8_t breakpointSize = CLAIR_BREAKPOINT_OFFSET_SIZE + 2;
+  message->numberOfSamples = (payload[0] & 0x7) + 1;
+  if (length < CLAIR_HEADER_SIZE + message->numberOfSamples * breakpointSize) return false;
+
+  const uint8_t *breakpoints = payload + CLAIR_HEADER_SIZE;
+  message->precedingGapSeconds = breakpoints[0] * CLAIR_BREAKPOINT_OFFSET_UNIT_SECS;
+
+  // the offsets go forward in time, the ages backward from the last breakpoint
+  uint32_t age = payload[1] * CLAIR_BREAKPOINT_OFFSET_UNIT_SECS;
+  for (int i = message->numberOfSamples - 1; i >= 0; i--) {
+    const uint8_t *breakpoint = breakpoints + i * breakpointSize;
+    message->samples[i] = dequantize(readSample(breakpoint + CLAIR_BREAKPOINT_OFFSET_SIZE));
+    message->samples[i].ageSeconds = age;
+    age += breakpoint[0] * CLAIR_BREAKPOINT_OFFSET_UNIT_SECS;
+  }
+  return true;
+}
+
+static bool decodeAlert(const uint8_t *payload, uint8_t length, decoded_message_t *message) {
+  if (length < CLAIR_HEADER_SIZE + 2) return false;
+
+  message->airQuality = payload[0] & 0x7;
+  message->co2TrendPpmPerMinute = static_cast<int8_t>(payload[1]) * CLAIR_ALERT_TREND_UNIT_PPM_PER_MINUTE;
+  message->numberOfSamples = 1;
+  message->samples[0] = dequantize(readSample(payload + CLAIR_HEADER_SIZE));
+  return true;
+}
+
+// sample lists are equispaced; version 1 lists end with a backlog if their last sample was not taken right before
+// transmission, version 2 lists with its age
+static bool setSampleAges(decoded_message_t *message, const uint8_t *end, const uint8_t *payloadEnd) {
+  uint32_t ageSeconds = 0;
+  if (message->version < 2) {
+    message->backlogSamples = end < payloadEnd ? *end : 0;
+    ageSeconds = static_cast<uint32_t>(message->backlogSamples) * message->samplingPeriodSeconds;
+  } else if (end < payloadEnd) {
+    ageSeconds = *end & 0x7F;
+    if (*end & 0x80) {
+      if (end + 1 == payloadEnd) return false;
+      ageSeconds = (*end & 0x3F) << 8 | end[1];
+      if (*end & 0x40) {
+        // the node could not tell the age, so the samples cannot be dated
+        if (ageSeconds == CLAIR_SAMPLE_AGE_SATURATED) return false;
+        ageSeconds *= CLAIR_SAMPLE_AGE_COARSE_UNIT_SECS;
+      }
+    }
+  }
+  message->transmissionDelaySeconds = ageSeconds;
+  for (uint8_t i = 0; i < message->numberOfSamples; i++) {
+    message->samples[i].ageSeconds = ageSeconds
+      + static_cast<uint32_t>(message->numberOfSamples - 1 - i) * message->samplingPeriodSeconds;
+  }
+  return true;
+}
+
+bool decodeClairchenMessage(const uint8_t *payload, uint8_t length, decoded_message_t *message) {
+  if (length < 1) return false;
+
+  message->version = payload[0] >> 6;
+  message->messageId = (payload[0] >> 3) & 0x7;
+  uint8_t messageHeader = payload[0] & 0x7;
+
+  // version 0 messages have no sampling period
+  uint8_t headerSize = message->version == 0 ? 1 : 2;
+  if (length < headerSize) return false;
+  message->samplingPeriodSeconds = message->version == 0 ? 0 : payload[1] * CLAIR_SAMPLING_PERIOD_UNIT_SECS;
+  message->precedingGapSeconds = 0;
+  message->backlogSamples = 0;
+  message->transmissionDelaySeconds = 0;
+  message->airQuality = 0;
+  message->co2TrendPpmPerMinute = 0;
+
+  if (message->version > 0 && message->messageId == CLAIR_MESSAGE_ID_BREAKPOINT_LIST) {
+    message->samplingPeriodSeconds = 0;
+    return decodeBreakpoints(payload, length, message);
+  }
+  if (message->version > 0 && message->messageId == CLAIR_MESSAGE_ID_HEARTBEAT) {
+    message->numberOfSamples = 0;
+    return length >= CLAIR_HEADER_SIZE;
+  }
+  if (message->version > 0 && message->messageId == CLAIR_MESSAGE_ID_ALERT) {
+    message->samplingPeriodSeconds = 0;
+    return decodeAlert(payload, length, message);
+  }
+
+  const uint8_t *samples = payload + headerSize;
+  uint8_t samplesLength = length - headerSize;
+
+  if (message->messageId == CLAIR_MESSAGE_ID_SAMPLE_LIST) {
+    message->numberOfSamples = messageHeader + 1;
+    if (samplesLength < message->numberOfSamples * 2) return false;
+    for (uint8_t i = 0; i < message->numberOfSamples; i++) {
+      message->samples[i] = dequantize(readSample(samples + 2 * i));
+    }
+    return setSampleAges(message, samples + message->numberOfSamples * 2, payload + length);
+  }
+
+  if (message->version == 0) return false;
+
+  // backfill lists are Rice-coded sample lists, of samples that are older than the given age
+  bool backfill = message->messageId == CLAIR_MESSAGE_ID_BACKFILL_LIST;
+  uint32_t ageSeconds = 0;
+  if (backfill) {
+    if (samplesLength < CLAIR_BACKFILL_AGE_SIZE) return false;
+    ageSeconds = (samples[0] << 8 | samples[1]) * static_cast<uint32_t>(CLAIR_BACKFILL_AGE_UNIT_SECS);
+    samples += CLAIR_BACKFILL_AGE_SIZE;
+    samplesLength -= CLAIR_BACKFILL_AGE_SIZE;
+  } else if (message->messageId != CLAIR_MESSAGE_ID_DELTA_LIST && message->messageId != CLAIR_MESSAGE_ID_RICE_LIST) {
+    return false;
+  }
+  if (samplesLength < 3) return false;
+
+  quantized_sample_t sample = readSample(samples);
+  message->samples[0] = dequantize(sample);
+
+  bit_reader_t reader = { samples + 3, static_cast<uint16_t>((samplesLength - 3) * 8), 0 };
+  uint8_t parameters[3];
+  if (message->messageId == CLAIR_MESSAGE_ID_DELTA_LIST) {
+    message->numberOfSamples = messageHeader + 1;
+    parameters[0] = samples[2] >> 4;
+  } else {
+    message->numberOfSamples = (samples[2] >> 4) + 1;
+    parameters[0] = messageHeader;
+  }
+  parameters[1] = (samples[2] >> 2) & 0x3;
+  parameters[2] = samples[2] & 0x3;
+
+  for (uint8_t i = 1; i < message->numberOfSamples; i++) {
+    int16_t deltas[3];
+    for (uint8_t j = 0; j < 3; j++) {
+      bool ok = message->messageId == CLAIR_MESSAGE_ID_DELTA_LIST
+        ? readSignedBits(&reader, parameters[j], &deltas[j])
+        : readRiceCode(&reader, parameters[j], &deltas[j]);
+      if (!ok) return false;
+    }
+    sample.co2 += deltas[0];
+    sample.temperature += deltas[1];
+    sample.humidity += deltas[2];
+    message->samples[i] = dequantize(sample);
+  }
+  if (backfill) {
+    for (uint8_t i = 0; i < message->numberOfSamples; i++) {
+      message->samples[i].ageSeconds = ageSeconds
+        + static_cast<uint32_t>(message->numberOfSamples - 1 - i) * message->samplingPeriodSeconds;
+    }
+    return true;
+  }
+  return setSampleAges(message, samples + 3 + (reader.position + 7) / 8, payload + length);
+}
+
+static int32_t interpolate(int32_t from, int32_t to, uint32_t position, uint32_t span) {
+  int32_t difference = (to - from) * static_cast<int32_t>(position);
+  int32_t half = static_cast<int32_t>(span / 2);
+  return from + (difference >= 0 ? difference + half : difference - half) / static_cast<int32_t>(span);
+}
+
+uint16_t reconstructClairchenSeries(const decoded_message_t *message, uint16_t stepSeconds,
+    decoded_sample_t *series, uint16_t maxNumberOfSamples) {
+  if (message->numberOfSamples == 0 || stepSeconds == 0) return 0;
+
+  const decoded_sample_t *samples = message->samples;
+  uint8_t next = 0;
+  uint16_t count = 0;
+  for (int64_t age = samples[0].ageSeconds; age >= samples[message->numberOfSamples - 1].ageSeconds; age -= stepSeconds) {
+    if (count == maxNumberOfSamples) break;
+
+    while (next < message->numberOfSamples - 1 && samples[next].ageSeconds > age) next += 1;
+    decoded_sample_t sample = samples[next];
+    if (next > 0 && samples[next].ageSeconds < age) {
+      const decoded_sample_t &from = samples[next - 1];
+      const decoded_sample_t &to = samples[next];
+      uint32_t span = from.ageSeconds - to.ageSeconds;
+      uint32_t position = from.ageSeconds - age;
+      sample.co2ppm = interpolate(from.co2ppm, to.co2ppm, position, span);
+      sample.temperature = interpolate(from.temperature, to.temperature, position, span);
+      sample.humidity = interpolate(from.humidity, to.humidity, position, span);
+    }
+    sample.ageSeconds = age;
+    series[count++] = sample;
+  }
+  return count;
+}
@@ -0,0 +1,52 @@
+#ifndef CLAIRCHEN_DECODER_H
+#define CLAIRCHEN_DECODER_H
+
+/*
+ * Host-side decoder of Clairchen uplink messages, the counterpart of
+ * clairchen_codec.h and Clair::encodeMessage(). See docs/message-format.md.
+ */
+
+#include <stdint.h>
+
+#define CLAIRCHEN_DECODER_MAX_NROF_SAMPLES 16
+
+typedef struct {
+  uint16_t co2ppm;
+  uint8_t temperature; // °C
+  uint8_t humidity; // %
+  uint32_t ageSeconds; // at transmission, 0 if unknown (version 0)
+} decoded_sample_t;
+
+typedef struct {
+  uint8_t version;
+  uint8_t messageId;
+  uint16_t samplingPeriodSeconds; // 0 if unknown (version 0) or for breakpoint lists
+  uint16_t precedingGapSeconds; // breakpoint lists: from the last breakpoint of the previous message
+  uint8_t airQuality; // alerts: CO2AirQuality of display.h, from 0 (very good) to 4 (critical)
+  int16_t co2TrendPpmPerMinute; // alerts
+  uint8_t numberOfSamples;
+  uint8_t backlogSamples; // version 1 sample lists: sampling periods to the newest sample the node still had queued
+  uint32_t transmissionDelaySeconds; // sample lists: from the last sample to transmission
+  decoded_sample_t samples[CLAIRCHEN_DECODER_MAX_NROF_SAMPLES]; // oldest first
+} decoded_message_t;
+
+/**
+ * Decodes a sample list message, plain, delta, or Rice encoded, a
+ * breakpoint list message, an alert, which holds the latest reading, a
+ * heartbeat, which holds no samples, or a backfill list of logged samples.
+ *
+ * Returns false if the message is malformed or of an unknown type, or if it
+ * is a sample list whose samples are too old to be dated.
+ */
+bool decodeClairchenMessage(const uint8_t *payload, uint8_t length, decoded_message_t *message);
+
+/**
+ * Rebuilds the series of a decoded message by linear interpolation between
+ * its samples, from the oldest one on, every stepSeconds.
+ *
+ * Returns the number of samples stored in series, at most maxNumberOfSamples.
+ */
+uint16_t reconstructClairchenSeries(const decoded_message_t *message, uint16_t stepSeconds,
+    decoded_sample_t *series, uint16_t maxNumberOfSamples);
+
+#endif /* CLAIRCHEN_DECODER_H */
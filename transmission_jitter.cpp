@@ -0,0 +1,43 @@
+#include "transmission_jitter.h"
+
+TransmissionJitter::TransmissionJitter() {
+  phase = 0;
+  randomState = 1;
+}
+
+void TransmissionJitter::begin(const uint8_t devEui[TRANSMISSION_JITTER_DEVEUI_SIZE]) {
+  // FNV-1a, followed by the MurmurHash3 finalizer, so that DevEUIs that differ in a single bit get unrelated phases
+  uint32_t hash = 2166136261UL;
+  for (uint8_t i = 0; i < TRANSMISSION_JITTER_DEVEUI_SIZE; i++) {
+    hash ^= devEui[i];
+    hash *= 16777619UL;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6BUL;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35UL;
+  hash ^= hash >> 16;
+
+  phase = hash >> 16;
+  // xorshift never leaves 0
+  randomState = hash != 0 ? hash : 1;
+}
+
+uint32_t TransmissionJitter::delayMillis(uint32_t boundMillis) {
+  uint32_t halfBoundMillis = boundMillis / 2;
+  uint32_t phaseMillis = (static_cast<uint64_t>(halfBoundMillis) * phase) >> 16;
+  uint32_t jitterMillis = (static_cast<uint64_t>(halfBoundMillis) * nextRandom()) >> 16;
+  return phaseMillis + jitterMillis;
+}
+
+uint16_t TransmissionJitter::getPhase() const {
+  return phase;
+}
+
+uint16_t TransmissionJitter::nextRandom() {
+  // xorshift32
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState >> 16;
+}
@@ -0,0 +1,53 @@
+#ifndef TRANSMISSION_JITTER_H
+#define TRANSMISSION_JITTER_H
+
+#include <stdint.h>
+
+/* 1 to delay uplinks as described below, 0 to send them as soon as they are due */
+#ifndef CLAIR_TX_JITTER
+#define CLAIR_TX_JITTER 1
+#endif
+
+#define TRANSMISSION_JITTER_DEVEUI_SIZE 8
+
+/**
+ * Spreads the uplinks of a fleet of nodes over time.
+ *
+ * Nodes that are powered up together, e.g., after a power cut in a building,
+ * or that sample at the same instants of UTC, have their messages due at
+ * the same time and would send them in lockstep, so that they collide again
+ * and again. Instead, each node delays its uplinks by a fixed phase, derived
+ * from its DevEUI, plus a pseudo-random jitter that changes from message to
+ * message. Both are less than half the given bound, so that the delay as a
+ * whole stays below it.
+ */
+class TransmissionJitter {
+  public:
+    /**
+     * Constructor
+     */
+    TransmissionJitter();
+
+    /**
+     * Derive the phase and seed the jitter from the DevEUI of the node.
+     */
+    void begin(const uint8_t devEui[TRANSMISSION_JITTER_DEVEUI_SIZE]);
+
+    /**
+     * Delay of the next uplink, less than the given bound, in milliseconds
+     */
+    uint32_t delayMillis(uint32_t boundMillis);
+
+    /**
+     * Fixed part of the delay, in 1/65536 of half the bound
+     */
+    uint16_t getPhase() const;
+
+  private:
+    uint16_t phase;
+    uint32_t randomState;
+
+    uint16_t nextRandom();
+};
+
+#endif /* TRANSMISSION_JITTER_H */